@@ -0,0 +1,170 @@
+#ifndef AST_WALKER_H
+#define AST_WALKER_H
+
+#include "ast.h"
+#include <string>
+#include <unordered_set>
+
+namespace orion {
+
+// Visitor that walks every child of every node.
+// Analysis passes derive from it and override only the nodes they care about,
+// calling the base implementation to keep descending.
+class RecursiveASTVisitor : public ASTVisitor {
+public:
+    void visit(IntLiteral&) override {}
+    void visit(FloatLiteral&) override {}
+    void visit(StringLiteral&) override {}
+    void visit(BoolLiteral&) override {}
+    void visit(Identifier&) override {}
+
+    void visit(InterpolatedString& node) override {
+        for (auto& part : node.parts) {
+            if (part.isExpression && part.expression) part.expression->accept(*this);
+        }
+    }
+
+    void visit(BinaryExpression& node) override {
+        node.left->accept(*this);
+        node.right->accept(*this);
+    }
+
+    void visit(UnaryExpression& node) override {
+        node.operand->accept(*this);
+    }
+
+    void visit(FunctionCall& node) override {
+        for (auto& arg : node.arguments) arg->accept(*this);
+    }
+
+    void visit(TupleExpression& node) override {
+        for (auto& element : node.elements) element->accept(*this);
+    }
+
+    void visit(ListLiteral& node) override {
+        for (auto& element : node.elements) element->accept(*this);
+    }
+
+    void visit(IndexExpression& node) override {
+        node.object->accept(*this);
+        node.index->accept(*this);
+    }
+
+    void visit(VariableDeclaration& node) override {
+        if (node.initializer) node.initializer->accept(*this);
+    }
+
+    void visit(FunctionDeclaration& node) override {
+        if (node.isSingleExpression) {
+            if (node.expression) node.expression->accept(*this);
+        } else {
+            for (auto& stmt : node.body) stmt->accept(*this);
+        }
+    }
+
+    void visit(BlockStatement& node) override {
+        for (auto& stmt : node.statements) stmt->accept(*this);
+    }
+
+    void visit(ExpressionStatement& node) override {
+        node.expression->accept(*this);
+    }
+
+    void visit(TupleAssignment& node) override {
+        for (auto& target : node.targets) target->accept(*this);
+        for (auto& value : node.values) value->accept(*this);
+    }
+
+    void visit(ChainAssignment& node) override {
+        node.value->accept(*this);
+    }
+
+    void visit(IndexAssignment& node) override {
+        node.object->accept(*this);
+        node.index->accept(*this);
+        node.value->accept(*this);
+    }
+
+    void visit(GlobalStatement&) override {}
+    void visit(LocalStatement&) override {}
+
+    void visit(ReturnStatement& node) override {
+        if (node.value) node.value->accept(*this);
+    }
+
+    void visit(IfStatement& node) override {
+        node.condition->accept(*this);
+        node.thenBranch->accept(*this);
+        if (node.elseBranch) node.elseBranch->accept(*this);
+    }
+
+    void visit(WhileStatement& node) override {
+        node.condition->accept(*this);
+        node.body->accept(*this);
+    }
+
+    void visit(ForInStatement& node) override {
+        node.iterable->accept(*this);
+        node.body->accept(*this);
+    }
+
+    void visit(BreakStatement&) override {}
+    void visit(ContinueStatement&) override {}
+    void visit(PassStatement&) override {}
+    void visit(StructDeclaration&) override {}
+    void visit(EnumDeclaration&) override {}
+
+    void visit(Program& node) override {
+        for (auto& stmt : node.statements) stmt->accept(*this);
+    }
+};
+
+// Names a statement may assign, without looking into nested functions
+class AssignedNameCollector : public RecursiveASTVisitor {
+public:
+    explicit AssignedNameCollector(std::unordered_set<std::string>& names) : names(names) {}
+
+    using RecursiveASTVisitor::visit;
+
+    void visit(VariableDeclaration& node) override {
+        names.insert(node.name);
+        RecursiveASTVisitor::visit(node);
+    }
+    void visit(ChainAssignment& node) override {
+        names.insert(node.variables.begin(), node.variables.end());
+        RecursiveASTVisitor::visit(node);
+    }
+    void visit(TupleAssignment& node) override {
+        for (auto& target : node.targets) {
+            if (auto id = dynamic_cast<Identifier*>(target.get())) names.insert(id->name);
+        }
+        RecursiveASTVisitor::visit(node);
+    }
+    void visit(ForInStatement& node) override {
+        names.insert(node.variable);
+        RecursiveASTVisitor::visit(node);
+    }
+    void visit(GlobalStatement& node) override { names.insert(node.variables.begin(), node.variables.end()); }
+    void visit(LocalStatement& node) override { names.insert(node.variables.begin(), node.variables.end()); }
+    void visit(FunctionDeclaration&) override {}
+
+private:
+    std::unordered_set<std::string>& names;
+};
+
+// Names any global statement of the program shares, in every function
+class GlobalNameCollector : public RecursiveASTVisitor {
+public:
+    explicit GlobalNameCollector(std::unordered_set<std::string>& names) : names(names) {}
+
+    using RecursiveASTVisitor::visit;
+
+    void visit(GlobalStatement& node) override { names.insert(node.variables.begin(), node.variables.end()); }
+
+private:
+    std::unordered_set<std::string>& names;
+};
+
+} // namespace orion
+
+#endif // AST_WALKER_H
@@ -0,0 +1,545 @@
+#ifndef CONSTANT_FOLDING_H
+#define CONSTANT_FOLDING_H
+
+#include "ast.h"
+#include "ast_walker.h"
+#include "float_text.h"
+#include "strength_reduction.h"
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace orion {
+
+// Folds constant expressions and propagates known variable values through the
+// AST before code generation. Values are tracked flow-sensitively: branches are
+// merged by keeping what both sides agree on, loops forget every variable they
+// assign, and if/while statements whose condition is known are replaced by the
+// branch that runs. Folding only happens where the result is exactly what the
+// generated code would compute at runtime.
+class ConstantFolder {
+public:
+    void run(Program& program) {
+        globalConstants.clear();
+        declaredGlobalNames.clear();
+        deferredFunctions.clear();
+
+        GlobalNameCollector globals(declaredGlobalNames);
+        program.accept(globals);
+
+        // Top-level code first so that `const` globals are known inside functions
+        Environment env;
+        foldStatements(program.statements, env);
+        for (auto& stmt : program.statements) {
+            auto decl = dynamic_cast<VariableDeclaration*>(stmt.get());
+            if (decl && decl->isConstant && isLiteral(decl->initializer.get())) {
+                globalConstants[decl->name] = cloneLiteral(decl->initializer.get());
+            }
+        }
+
+        for (size_t i = 0; i < deferredFunctions.size(); i++) {
+            foldFunction(*deferredFunctions[i]);
+        }
+    }
+
+private:
+    using Environment = std::unordered_map<std::string, std::unique_ptr<Expression>>;
+
+    Environment globalConstants;                     // Top-level `const` variables with known values
+    std::unordered_set<std::string> declaredGlobalNames; // Names some function writes through `global`
+    std::vector<FunctionDeclaration*> deferredFunctions;
+
+    // ---- Statements ----
+
+    void foldStatements(std::vector<std::unique_ptr<Statement>>& statements, Environment& env) {
+        for (auto& stmt : statements) {
+            foldStatement(stmt, env);
+        }
+    }
+
+    void foldStatement(std::unique_ptr<Statement>& stmt, Environment& env) {
+        if (auto decl = dynamic_cast<VariableDeclaration*>(stmt.get())) {
+            if (!decl->initializer) return;
+            foldExpression(decl->initializer, env);
+            bind(env, decl->name, decl->initializer.get());
+        } else if (auto exprStmt = dynamic_cast<ExpressionStatement*>(stmt.get())) {
+            foldExpression(exprStmt->expression, env);
+        } else if (auto ret = dynamic_cast<ReturnStatement*>(stmt.get())) {
+            if (ret->value) foldExpression(ret->value, env);
+        } else if (auto block = dynamic_cast<BlockStatement*>(stmt.get())) {
+            foldStatements(block->statements, env);
+        } else if (auto ifStmt = dynamic_cast<IfStatement*>(stmt.get())) {
+            foldExpression(ifStmt->condition, env);
+            int truth = constantTruth(ifStmt->condition.get());
+            if (truth >= 0) {
+                // Only the branch that runs is kept
+                std::unique_ptr<Statement> taken = truth ? std::move(ifStmt->thenBranch) : std::move(ifStmt->elseBranch);
+                stmt = taken ? std::move(taken) : emptyBlock();
+                foldStatement(stmt, env);
+                return;
+            }
+            Environment elseEnv = copyEnvironment(env);
+            foldStatement(ifStmt->thenBranch, env);
+            if (ifStmt->elseBranch) foldStatement(ifStmt->elseBranch, elseEnv);
+            meet(env, elseEnv);
+        } else if (auto whileStmt = dynamic_cast<WhileStatement*>(stmt.get())) {
+            // A loop whose condition is false on entry never runs
+            std::unique_ptr<Expression> entry = evaluate(whileStmt->condition.get(), env);
+            if (entry && constantTruth(entry.get()) == 0) {
+                stmt = emptyBlock();
+                return;
+            }
+            forgetAssigned(*stmt, env);
+            Environment bodyEnv = copyEnvironment(env);
+            foldExpression(whileStmt->condition, bodyEnv);
+            foldStatement(whileStmt->body, bodyEnv);
+        } else if (auto forStmt = dynamic_cast<ForInStatement*>(stmt.get())) {
+            foldExpression(forStmt->iterable, env);
+            forgetAssigned(*stmt, env);
+            Environment bodyEnv = copyEnvironment(env);
+            foldStatement(forStmt->body, bodyEnv);
+        } else if (auto tuple = dynamic_cast<TupleAssignment*>(stmt.get())) {
+            for (auto& value : tuple->values) foldExpression(value, env);
+            for (auto& target : tuple->targets) {
+                if (auto id = dynamic_cast<Identifier*>(target.get())) env.erase(id->name);
+            }
+        } else if (auto chain = dynamic_cast<ChainAssignment*>(stmt.get())) {
+            foldExpression(chain->value, env);
+            for (const auto& name : chain->variables) bind(env, name, chain->value.get());
+        } else if (auto indexAssign = dynamic_cast<IndexAssignment*>(stmt.get())) {
+            foldExpression(indexAssign->index, env);
+            foldExpression(indexAssign->value, env);
+        } else if (auto global = dynamic_cast<GlobalStatement*>(stmt.get())) {
+            for (const auto& name : global->variables) env.erase(name);
+        } else if (auto local = dynamic_cast<LocalStatement*>(stmt.get())) {
+            for (const auto& name : local->variables) env.erase(name);
+        } else if (auto func = dynamic_cast<FunctionDeclaration*>(stmt.get())) {
+            deferredFunctions.push_back(func);
+        }
+    }
+
+    // Function bodies start from nothing but the `const` globals they do not shadow
+    void foldFunction(FunctionDeclaration& func) {
+        std::unordered_set<std::string> shadowed;
+        for (const auto& param : func.parameters) shadowed.insert(param.name);
+        AssignedNameCollector assigned(shadowed);
+        for (auto& stmt : func.body) stmt->accept(assigned);
+
+        Environment env;
+        for (const auto& entry : globalConstants) {
+            if (!shadowed.count(entry.first)) env[entry.first] = cloneLiteral(entry.second.get());
+        }
+        if (func.isSingleExpression) {
+            if (func.expression) foldExpression(func.expression, env);
+        } else {
+            foldStatements(func.body, env);
+        }
+    }
+
+    void bind(Environment& env, const std::string& name, Expression* value) {
+        // Globals written from functions may change at any call
+        if (isLiteral(value) && !declaredGlobalNames.count(name)) {
+            env[name] = cloneLiteral(value);
+        } else {
+            env.erase(name);
+        }
+    }
+
+    void forgetAssigned(Statement& stmt, Environment& env) {
+        std::unordered_set<std::string> names;
+        AssignedNameCollector assigned(names);
+        stmt.accept(assigned);
+        for (const auto& name : names) env.erase(name);
+    }
+
+    // Keep only the values both paths agree on
+    static void meet(Environment& env, const Environment& other) {
+        for (auto it = env.begin(); it != env.end();) {
+            auto otherIt = other.find(it->first);
+            if (otherIt == other.end() || !sameLiteral(it->second.get(), otherIt->second.get())) {
+                it = env.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    static Environment copyEnvironment(const Environment& env) {
+        Environment copy;
+        for (const auto& entry : env) copy[entry.first] = cloneLiteral(entry.second.get());
+        return copy;
+    }
+
+    static std::unique_ptr<Statement> emptyBlock() {
+        return std::make_unique<BlockStatement>();
+    }
+
+    // ---- Expressions ----
+
+    void foldExpression(std::unique_ptr<Expression>& expr, const Environment& env) {
+        if (!expr) return;
+        if (auto value = evaluate(expr.get(), env)) {
+            expr = std::move(value);
+            return;
+        }
+        if (auto binary = dynamic_cast<BinaryExpression*>(expr.get())) {
+            foldExpression(binary->left, env);
+            foldExpression(binary->right, env);
+        } else if (auto unary = dynamic_cast<UnaryExpression*>(expr.get())) {
+            foldExpression(unary->operand, env);
+        } else if (auto call = dynamic_cast<FunctionCall*>(expr.get())) {
+            // dtype() reports the type the code generator tracks for the variable
+            // it names, so its argument stays as written
+            if (call->name == "dtype") return;
+            // append/pop take the list itself, which is never a tracked value
+            for (auto& arg : call->arguments) foldExpression(arg, env);
+        } else if (auto list = dynamic_cast<ListLiteral*>(expr.get())) {
+            for (auto& element : list->elements) foldExpression(element, env);
+        } else if (auto tuple = dynamic_cast<TupleExpression*>(expr.get())) {
+            for (auto& element : tuple->elements) foldExpression(element, env);
+        } else if (auto index = dynamic_cast<IndexExpression*>(expr.get())) {
+            foldExpression(index->index, env);
+        } else if (auto interpolated = dynamic_cast<InterpolatedString*>(expr.get())) {
+            foldInterpolation(expr, *interpolated, env);
+        }
+    }
+
+    // Constant parts become text, formatted the way the runtime converters would
+    void foldInterpolation(std::unique_ptr<Expression>& expr, InterpolatedString& node, const Environment& env) {
+        bool allText = true;
+        for (auto& part : node.parts) {
+            if (!part.isExpression) continue;
+            std::unique_ptr<Expression> value = evaluate(part.expression.get(), env);
+            std::string text;
+            if (value && interpolationText(value.get(), text)) {
+                part.isExpression = false;
+                part.text = text;
+                part.expression.reset();
+            } else {
+                foldExpression(part.expression, env);
+                allText = false;
+            }
+        }
+        if (allText) {
+            std::string text;
+            for (const auto& part : node.parts) text += part.text;
+            expr = std::make_unique<StringLiteral>(text, node.line, node.column);
+        }
+    }
+
+    static bool interpolationText(Expression* value, std::string& text) {
+        if (auto i = dynamic_cast<IntLiteral*>(value)) {
+            text = std::to_string(i->value);
+        } else if (auto f = dynamic_cast<FloatLiteral*>(value)) {
+            text = format("%.2f", f->value);
+        } else if (auto b = dynamic_cast<BoolLiteral*>(value)) {
+            text = b->value ? "True" : "False";
+        } else if (auto s = dynamic_cast<StringLiteral*>(value)) {
+            text = s->value;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    // Returns the literal an expression always evaluates to, or null
+    std::unique_ptr<Expression> evaluate(Expression* expr, const Environment& env) {
+        if (isLiteral(expr)) {
+            return cloneLiteral(expr);
+        }
+        if (auto id = dynamic_cast<Identifier*>(expr)) {
+            auto it = env.find(id->name);
+            if (it == env.end()) return nullptr;
+            auto value = cloneLiteral(it->second.get());
+            value->line = id->line;
+            value->column = id->column;
+            return value;
+        }
+        if (auto unary = dynamic_cast<UnaryExpression*>(expr)) {
+            auto operand = evaluate(unary->operand.get(), env);
+            return operand ? evaluateUnary(unary->op, operand.get(), expr) : nullptr;
+        }
+        if (auto binary = dynamic_cast<BinaryExpression*>(expr)) {
+            auto left = evaluate(binary->left.get(), env);
+            if (!left) return nullptr;
+            auto right = evaluate(binary->right.get(), env);
+            if (!right) return nullptr;
+            return evaluateBinary(binary->op, left.get(), right.get(), expr);
+        }
+        if (auto call = dynamic_cast<FunctionCall*>(expr)) {
+            return evaluateCall(*call, env);
+        }
+        return nullptr;
+    }
+
+    std::unique_ptr<Expression> evaluateUnary(UnaryOp op, Expression* operand, Expression* at) {
+        auto i = dynamic_cast<IntLiteral*>(operand);
+        auto f = dynamic_cast<FloatLiteral*>(operand);
+        switch (op) {
+            case UnaryOp::PLUS:
+                return (i || f) ? withPosition(cloneLiteral(operand), at) : nullptr;
+            case UnaryOp::MINUS:
+                if (i) return makeInt(-static_cast<int64_t>(i->value), at);
+                if (f) return std::make_unique<FloatLiteral>(-f->value, at->line, at->column);
+                return nullptr;
+            case UnaryOp::NOT: {
+                int truth = constantTruth(operand);
+                if (truth < 0 || dynamic_cast<StringLiteral*>(operand) || f) return nullptr;
+                return std::make_unique<BoolLiteral>(!truth, at->line, at->column);
+            }
+        }
+        return nullptr;
+    }
+
+    std::unique_ptr<Expression> evaluateBinary(BinaryOp op, Expression* left, Expression* right, Expression* at) {
+        if (op == BinaryOp::AND || op == BinaryOp::OR) {
+            // Only ints and bools have a truth value the generated code agrees with
+            bool leftScalar = dynamic_cast<IntLiteral*>(left) || dynamic_cast<BoolLiteral*>(left);
+            bool rightScalar = dynamic_cast<IntLiteral*>(right) || dynamic_cast<BoolLiteral*>(right);
+            if (!leftScalar || !rightScalar) return nullptr;
+            bool l = constantTruth(left) == 1;
+            bool r = constantTruth(right) == 1;
+            return std::make_unique<BoolLiteral>(op == BinaryOp::AND ? (l && r) : (l || r), at->line, at->column);
+        }
+
+        auto li = dynamic_cast<IntLiteral*>(left);
+        auto ri = dynamic_cast<IntLiteral*>(right);
+        if (li && ri) {
+            return evaluateIntBinary(op, li->value, ri->value, at);
+        }
+
+        auto lf = dynamic_cast<FloatLiteral*>(left);
+        auto rf = dynamic_cast<FloatLiteral*>(right);
+        if ((lf || li) && (rf || ri)) {
+            double a = lf ? lf->value : static_cast<double>(li->value);
+            double b = rf ? rf->value : static_cast<double>(ri->value);
+            return evaluateFloatBinary(op, a, b, at);
+        }
+
+        auto ls = dynamic_cast<StringLiteral*>(left);
+        auto rs = dynamic_cast<StringLiteral*>(right);
+        if (ls && rs) {
+            if (op == BinaryOp::ADD) {
+                return std::make_unique<StringLiteral>(ls->value + rs->value, at->line, at->column);
+            }
+            if (isComparison(op)) {
+                // strcmp orders by unsigned bytes, as std::string::compare does
+                return compareResult(op, ls->value.compare(rs->value), at);
+            }
+        }
+        return nullptr;
+    }
+
+    std::unique_ptr<Expression> evaluateIntBinary(BinaryOp op, int64_t a, int64_t b, Expression* at) {
+        switch (op) {
+            case BinaryOp::ADD: return makeInt(a + b, at);
+            case BinaryOp::SUB: return makeInt(a - b, at);
+            case BinaryOp::MUL: return makeInt(a * b, at);
+            case BinaryOp::DIV:
+            case BinaryOp::FLOOR_DIV:
+            case BinaryOp::MOD:
+                // Division by zero is left to the runtime
+                if (b == 0) return nullptr;
+                if (op == BinaryOp::DIV) return makeInt(a / b, at);
+                return makeInt(op == BinaryOp::MOD ? intmath::floorMod(a, b) : intmath::floorDiv(a, b), at);
+            case BinaryOp::POWER: {
+                if (b < 0) {
+                    // Integer powers truncate: only bases 1 and -1 stay non-zero
+                    if (a == 1) return makeInt(1, at);
+                    if (a == -1) return makeInt(b % 2 == 0 ? 1 : -1, at);
+                    return makeInt(0, at);
+                }
+                if (a == 0) return makeInt(b == 0 ? 1 : 0, at);
+                if (a == 1) return makeInt(1, at);
+                if (a == -1) return makeInt(b % 2 == 0 ? 1 : -1, at);
+                // |a| >= 2 overflows 32 bits within 32 steps
+                int64_t result = 1;
+                for (int64_t k = 0; k < b; k++) {
+                    result *= a;
+                    if (result > INT32_MAX || result < INT32_MIN) return nullptr;
+                }
+                return makeInt(result, at);
+            }
+            default:
+                if (isComparison(op)) return compareResult(op, a < b ? -1 : (a > b ? 1 : 0), at);
+                return nullptr;
+        }
+    }
+
+    std::unique_ptr<Expression> evaluateFloatBinary(BinaryOp op, double a, double b, Expression* at) {
+        switch (op) {
+            case BinaryOp::ADD: return std::make_unique<FloatLiteral>(a + b, at->line, at->column);
+            case BinaryOp::SUB: return std::make_unique<FloatLiteral>(a - b, at->line, at->column);
+            case BinaryOp::MUL: return std::make_unique<FloatLiteral>(a * b, at->line, at->column);
+            case BinaryOp::DIV: return std::make_unique<FloatLiteral>(a / b, at->line, at->column);
+            case BinaryOp::FLOOR_DIV: return std::make_unique<FloatLiteral>(std::floor(a / b), at->line, at->column);
+            case BinaryOp::MOD: return std::make_unique<FloatLiteral>(std::fmod(a, b), at->line, at->column);
+            case BinaryOp::POWER: return std::make_unique<FloatLiteral>(std::pow(a, b), at->line, at->column);
+            default:
+                if (!isComparison(op) || std::isnan(a) || std::isnan(b)) return nullptr;
+                return compareResult(op, a < b ? -1 : (a > b ? 1 : 0), at);
+        }
+    }
+
+    std::unique_ptr<Expression> evaluateCall(FunctionCall& call, const Environment& env) {
+        if (call.arguments.size() != 1) return nullptr;
+
+        if (call.name == "len") {
+            // Every element must be constant, so dropping them loses no side effects
+            auto list = dynamic_cast<ListLiteral*>(call.arguments[0].get());
+            if (!list) return nullptr;
+            for (auto& element : list->elements) {
+                if (!evaluate(element.get(), env)) return nullptr;
+            }
+            return makeInt(static_cast<int64_t>(list->elements.size()), &call);
+        }
+        if (call.name != "str" && call.name != "int" && call.name != "flt") return nullptr;
+
+        auto arg = evaluate(call.arguments[0].get(), env);
+        if (!arg) return nullptr;
+        auto i = dynamic_cast<IntLiteral*>(arg.get());
+        auto f = dynamic_cast<FloatLiteral*>(arg.get());
+        auto b = dynamic_cast<BoolLiteral*>(arg.get());
+        auto s = dynamic_cast<StringLiteral*>(arg.get());
+
+        if (call.name == "str") {
+            // Same formats as the __orion_*_to_string runtime helpers
+            std::string text;
+            if (i) text = std::to_string(i->value);
+            else if (f) text = shortestFloatText(f->value);
+            else if (b) text = b->value ? "true" : "false";
+            else text = s->value;
+            return std::make_unique<StringLiteral>(text, call.line, call.column);
+        }
+        if (call.name == "int") {
+            if (i) return makeInt(i->value, &call);
+            if (b) return makeInt(b->value ? 1 : 0, &call);
+            if (f) {
+                if (!(f->value > INT32_MIN - 1.0 && f->value < INT32_MAX + 1.0)) return nullptr;
+                return makeInt(static_cast<int64_t>(f->value), &call);
+            }
+            // Malformed strings keep their runtime error
+            errno = 0;
+            char* end = nullptr;
+            long long value = std::strtoll(s->value.c_str(), &end, 10);
+            if (errno != 0 || end == s->value.c_str() || *end != '\0') return nullptr;
+            return makeInt(value, &call);
+        }
+        // flt()
+        double value;
+        if (i) value = static_cast<double>(i->value);
+        else if (f) value = f->value;
+        else if (b) value = b->value ? 1.0 : 0.0;
+        else {
+            errno = 0;
+            char* end = nullptr;
+            value = std::strtod(s->value.c_str(), &end);
+            if (errno != 0 || end == s->value.c_str() || *end != '\0') return nullptr;
+        }
+        return std::make_unique<FloatLiteral>(value, call.line, call.column);
+    }
+
+    // ---- Helpers ----
+
+    static bool isComparison(BinaryOp op) {
+        return op == BinaryOp::EQ || op == BinaryOp::NE || op == BinaryOp::LT ||
+               op == BinaryOp::LE || op == BinaryOp::GT || op == BinaryOp::GE;
+    }
+
+    static std::unique_ptr<Expression> compareResult(BinaryOp op, int order, Expression* at) {
+        bool result = false;
+        switch (op) {
+            case BinaryOp::EQ: result = order == 0; break;
+            case BinaryOp::NE: result = order != 0; break;
+            case BinaryOp::LT: result = order < 0; break;
+            case BinaryOp::LE: result = order <= 0; break;
+            case BinaryOp::GT: result = order > 0; break;
+            case BinaryOp::GE: result = order >= 0; break;
+            default: break;
+        }
+        return std::make_unique<BoolLiteral>(result, at->line, at->column);
+    }
+
+    // Integer literals are 32-bit in the AST; anything wider stays a runtime computation
+    static std::unique_ptr<Expression> makeInt(int64_t value, Expression* at) {
+        if (value > INT32_MAX || value < INT32_MIN) return nullptr;
+        return std::make_unique<IntLiteral>(static_cast<int32_t>(value), at->line, at->column);
+    }
+
+    static std::unique_ptr<Expression> withPosition(std::unique_ptr<Expression> value, Expression* at) {
+        value->line = at->line;
+        value->column = at->column;
+        return value;
+    }
+
+    // 1 if the value is truthy, 0 if falsy, -1 if not a scalar constant
+    static int constantTruth(Expression* expr) {
+        if (auto i = dynamic_cast<IntLiteral*>(expr)) return i->value != 0;
+        if (auto b = dynamic_cast<BoolLiteral*>(expr)) return b->value;
+        return -1;
+    }
+
+    static bool isLiteral(Expression* expr) {
+        return dynamic_cast<IntLiteral*>(expr) || dynamic_cast<FloatLiteral*>(expr) ||
+               dynamic_cast<StringLiteral*>(expr) || dynamic_cast<BoolLiteral*>(expr);
+    }
+
+    static std::unique_ptr<Expression> cloneLiteral(Expression* expr) {
+        if (auto i = dynamic_cast<IntLiteral*>(expr)) return std::make_unique<IntLiteral>(i->value, i->line, i->column);
+        if (auto f = dynamic_cast<FloatLiteral*>(expr)) return std::make_unique<FloatLiteral>(f->value, f->line, f->column);
+        if (auto s = dynamic_cast<StringLiteral*>(expr)) return std::make_unique<StringLiteral>(s->value, s->line, s->column);
+        if (auto b = dynamic_cast<BoolLiteral*>(expr)) return std::make_unique<BoolLiteral>(b->value, b->line, b->column);
+        return nullptr;
+    }
+
+    static bool sameLiteral(Expression* a, Expression* b) {
+        if (auto ai = dynamic_cast<IntLiteral*>(a)) {
+            auto bi = dynamic_cast<IntLiteral*>(b);
+            return bi && ai->value == bi->value;
+        }
+        if (auto af = dynamic_cast<FloatLiteral*>(a)) {
+            auto bf = dynamic_cast<FloatLiteral*>(b);
+            return bf && std::memcmp(&af->value, &bf->value, sizeof(double)) == 0;
+        }
+        if (auto as = dynamic_cast<StringLiteral*>(a)) {
+            auto bs = dynamic_cast<StringLiteral*>(b);
+            return bs && as->value == bs->value;
+        }
+        if (auto ab = dynamic_cast<BoolLiteral*>(a)) {
+            auto bb = dynamic_cast<BoolLiteral*>(b);
+            return bb && ab->value == bb->value;
+        }
+        return false;
+    }
+
+    static std::string format(const char* fmt, double value) {
+        char buffer[64];
+        std::snprintf(buffer, sizeof(buffer), fmt, value);
+        return buffer;
+    }
+
+    // Names written through a `global` statement in any function
+    class GlobalNameCollector : public RecursiveASTVisitor {
+    public:
+        explicit GlobalNameCollector(std::unordered_set<std::string>& names) : names(names) {}
+
+        using RecursiveASTVisitor::visit;
+
+        void visit(GlobalStatement& node) override { names.insert(node.variables.begin(), node.variables.end()); }
+
+    private:
+        std::unordered_set<std::string>& names;
+    };
+};
+
+} // namespace orion
+
+#endif // CONSTANT_FOLDING_H
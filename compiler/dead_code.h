@@ -0,0 +1,234 @@
+#ifndef DEAD_CODE_H
+#define DEAD_CODE_H
+
+#include "ast.h"
+#include "ast_walker.h"
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace orion {
+
+// Removes code that can never run or whose result is never observed:
+// statements following a return/break/continue in the same block, and
+// assignments of side-effect free values to variables that are never read
+// or are overwritten before the next read. Function declarations are always
+// kept since functions can be called before the point where they are defined.
+class DeadCodeEliminator {
+public:
+    void run(Program& program) {
+        readNames.clear();
+        globalNames.clear();
+
+        NameUseCollector uses(readNames, globalNames);
+        program.accept(uses);
+
+        eliminateInBlock(program.statements);
+
+        std::vector<FunctionDeclaration*> functions;
+        FunctionCollector collector(functions);
+        program.accept(collector);
+        for (FunctionDeclaration* func : functions) {
+            if (!func->isSingleExpression) eliminateInBlock(func->body);
+        }
+    }
+
+private:
+    std::unordered_set<std::string> readNames;   // Variables read anywhere in the program
+    std::unordered_set<std::string> globalNames; // Variables some function declares global
+
+    void eliminateInBlock(std::vector<std::unique_ptr<Statement>>& statements) {
+        for (auto& stmt : statements) {
+            eliminateInStatement(*stmt);
+        }
+
+        // Everything after a statement that always leaves the block is unreachable
+        for (size_t i = 0; i < statements.size(); i++) {
+            if (!alwaysLeavesBlock(statements[i].get())) continue;
+            std::vector<std::unique_ptr<Statement>> kept;
+            for (size_t j = 0; j <= i; j++) kept.push_back(std::move(statements[j]));
+            for (size_t j = i + 1; j < statements.size(); j++) {
+                if (dynamic_cast<FunctionDeclaration*>(statements[j].get())) {
+                    kept.push_back(std::move(statements[j]));
+                }
+            }
+            statements = std::move(kept);
+            break;
+        }
+
+        for (size_t i = 0; i < statements.size();) {
+            if (isDeadStore(statements, i)) {
+                statements.erase(statements.begin() + i);
+            } else {
+                i++;
+            }
+        }
+    }
+
+    void eliminateInStatement(Statement& stmt) {
+        if (auto block = dynamic_cast<BlockStatement*>(&stmt)) {
+            eliminateInBlock(block->statements);
+        } else if (auto ifStmt = dynamic_cast<IfStatement*>(&stmt)) {
+            eliminateInStatement(*ifStmt->thenBranch);
+            if (ifStmt->elseBranch) eliminateInStatement(*ifStmt->elseBranch);
+        } else if (auto whileStmt = dynamic_cast<WhileStatement*>(&stmt)) {
+            eliminateInStatement(*whileStmt->body);
+        } else if (auto forStmt = dynamic_cast<ForInStatement*>(&stmt)) {
+            eliminateInStatement(*forStmt->body);
+        }
+    }
+
+    static bool alwaysLeavesBlock(Statement* stmt) {
+        if (dynamic_cast<ReturnStatement*>(stmt) || dynamic_cast<BreakStatement*>(stmt) ||
+            dynamic_cast<ContinueStatement*>(stmt)) {
+            return true;
+        }
+        if (auto block = dynamic_cast<BlockStatement*>(stmt)) {
+            for (auto& inner : block->statements) {
+                if (alwaysLeavesBlock(inner.get())) return true;
+            }
+            return false;
+        }
+        if (auto ifStmt = dynamic_cast<IfStatement*>(stmt)) {
+            return ifStmt->elseBranch && alwaysLeavesBlock(ifStmt->thenBranch.get()) &&
+                   alwaysLeavesBlock(ifStmt->elseBranch.get());
+        }
+        return false;
+    }
+
+    // `x = <pure>` is dead if x is never read, or if a later statement in the same
+    // block overwrites x with nothing in between that could read it or jump away
+    bool isDeadStore(std::vector<std::unique_ptr<Statement>>& statements, size_t index) {
+        auto decl = dynamic_cast<VariableDeclaration*>(statements[index].get());
+        if (!decl || !decl->initializer || decl->isConstant || globalNames.count(decl->name) ||
+            !isPure(decl->initializer.get())) {
+            return false;
+        }
+        if (!readNames.count(decl->name)) {
+            return true;
+        }
+        for (size_t j = index + 1; j < statements.size(); j++) {
+            Statement* next = statements[j].get();
+            if (dynamic_cast<FunctionDeclaration*>(next)) continue;
+
+            StatementEffects effects(decl->name);
+            if (auto overwrite = dynamic_cast<VariableDeclaration*>(next)) {
+                if (overwrite->name == decl->name && !overwrite->isConstant && overwrite->initializer) {
+                    overwrite->initializer->accept(effects);
+                    return !effects.readsName && !effects.mayEscape;
+                }
+            }
+            next->accept(effects);
+            if (effects.readsName || effects.mayEscape) return false;
+        }
+        return false;
+    }
+
+    // Side-effect free and unable to trap: no calls other than str(), no division
+    static bool isPure(Expression* expr) {
+        if (dynamic_cast<IntLiteral*>(expr) || dynamic_cast<FloatLiteral*>(expr) ||
+            dynamic_cast<StringLiteral*>(expr) || dynamic_cast<BoolLiteral*>(expr) ||
+            dynamic_cast<Identifier*>(expr)) {
+            return true;
+        }
+        if (auto unary = dynamic_cast<UnaryExpression*>(expr)) {
+            return isPure(unary->operand.get());
+        }
+        if (auto binary = dynamic_cast<BinaryExpression*>(expr)) {
+            if (binary->op == BinaryOp::DIV || binary->op == BinaryOp::MOD ||
+                binary->op == BinaryOp::FLOOR_DIV || binary->op == BinaryOp::POWER) {
+                return false;
+            }
+            return isPure(binary->left.get()) && isPure(binary->right.get());
+        }
+        if (auto list = dynamic_cast<ListLiteral*>(expr)) {
+            for (auto& element : list->elements) {
+                if (!isPure(element.get())) return false;
+            }
+            return true;
+        }
+        if (auto interpolated = dynamic_cast<InterpolatedString*>(expr)) {
+            for (auto& part : interpolated->parts) {
+                if (part.isExpression && !isPure(part.expression.get())) return false;
+            }
+            return true;
+        }
+        if (auto call = dynamic_cast<FunctionCall*>(expr)) {
+            return call->name == "str" && call->arguments.size() == 1 && isPure(call->arguments[0].get());
+        }
+        return false;
+    }
+
+    // Whether a statement reads a variable or may transfer control out of the block
+    // (jumps, or user calls that could observe a global)
+    class StatementEffects : public RecursiveASTVisitor {
+    public:
+        bool readsName = false;
+        bool mayEscape = false;
+
+        explicit StatementEffects(const std::string& name) : name(name) {}
+
+        using RecursiveASTVisitor::visit;
+
+        void visit(Identifier& node) override {
+            if (node.name == name) readsName = true;
+        }
+        void visit(FunctionCall& node) override {
+            if (!isBuiltin(node.name)) mayEscape = true;
+            RecursiveASTVisitor::visit(node);
+        }
+        void visit(ReturnStatement& node) override {
+            mayEscape = true;
+            RecursiveASTVisitor::visit(node);
+        }
+        void visit(BreakStatement&) override { mayEscape = true; }
+        void visit(ContinueStatement&) override { mayEscape = true; }
+        void visit(GlobalStatement&) override { mayEscape = true; }
+        void visit(LocalStatement&) override { mayEscape = true; }
+        void visit(FunctionDeclaration&) override {}
+
+    private:
+        std::string name;
+
+        static bool isBuiltin(const std::string& name) {
+            return name == "str" || name == "int" || name == "flt" || name == "len" ||
+                   name == "append" || name == "pop" || name == "range" || name == "out" ||
+                   name == "input" || name == "dtype";
+        }
+    };
+
+    class NameUseCollector : public RecursiveASTVisitor {
+    public:
+        NameUseCollector(std::unordered_set<std::string>& reads, std::unordered_set<std::string>& globals)
+            : reads(reads), globals(globals) {}
+
+        using RecursiveASTVisitor::visit;
+
+        void visit(Identifier& node) override { reads.insert(node.name); }
+        void visit(GlobalStatement& node) override { globals.insert(node.variables.begin(), node.variables.end()); }
+
+    private:
+        std::unordered_set<std::string>& reads;
+        std::unordered_set<std::string>& globals;
+    };
+
+    class FunctionCollector : public RecursiveASTVisitor {
+    public:
+        explicit FunctionCollector(std::vector<FunctionDeclaration*>& functions) : functions(functions) {}
+
+        using RecursiveASTVisitor::visit;
+
+        void visit(FunctionDeclaration& node) override {
+            functions.push_back(&node);
+            RecursiveASTVisitor::visit(node);
+        }
+
+    private:
+        std::vector<FunctionDeclaration*>& functions;
+    };
+};
+
+} // namespace orion
+
+#endif // DEAD_CODE_H
@@ -0,0 +1,50 @@
+#ifndef FLOAT_TEXT_H
+#define FLOAT_TEXT_H
+
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace orion {
+
+// str() of a float as the compiled program prints it (orion_format_shortest in
+// runtime.c): the fewest significant digits that read back as the same double,
+// laid out like %g, plain decimals for exponents -4..14 and d.ddde+XX
+// otherwise. Text worked out at compile time has to match it byte for byte.
+inline std::string shortestFloatText(double value) {
+    char buffer[32];
+    if (!std::isfinite(value)) {
+        std::snprintf(buffer, sizeof buffer, "%g", value);
+        return buffer;
+    }
+    // [-]d[.ddd]e(+|-)XX
+    char* end = std::to_chars(buffer, buffer + sizeof buffer, value, std::chars_format::scientific).ptr;
+    std::string text(buffer, end);
+    std::string result;
+    if (text[0] == '-') {
+        result = "-";
+        text.erase(0, 1);
+    }
+    size_t mark = text.find('e');
+    int scientific = std::atoi(text.c_str() + mark + 1);
+    std::string digits = text.substr(0, mark);
+    if (digits.size() > 1) digits.erase(1, 1);
+    int length = static_cast<int>(digits.size());
+
+    if (scientific < -4 || scientific >= 15) {
+        char exponent[16];
+        std::snprintf(exponent, sizeof exponent, "e%c%02d", scientific < 0 ? '-' : '+', std::abs(scientific));
+        result += digits.substr(0, 1);
+        if (length > 1) result += "." + digits.substr(1);
+        return result + exponent;
+    }
+    if (scientific < 0) return result + "0." + std::string(-scientific - 1, '0') + digits;
+    if (length <= scientific + 1) return result + digits + std::string(scientific + 1 - length, '0');
+    return result + digits.substr(0, scientific + 1) + "." + digits.substr(scientific + 1);
+}
+
+} // namespace orion
+
+#endif // FLOAT_TEXT_H
@@ -0,0 +1,220 @@
+#ifndef FRAME_LAYOUT_H
+#define FRAME_LAYOUT_H
+
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace orion {
+
+// Stack frame of one generated function (or of main). The code generator
+// addresses slots as -N(%rbp), N = 8, 16, ... counted from the frame pointer, and
+// stack parameters as P(%rbp). It opens each function with enter(slotBytes) and
+// marks each place the frame must be torn down with kTeardownMarker; lower() runs
+// after the peephole optimizer, once the body is final, and for every function
+//   - saves only the callee-saved registers the body uses,
+//   - reserves exactly the slot bytes, rounded so that %rsp stays 16-byte aligned,
+//   - runs leaf bodies that never move %rsp without a frame at all: %rbp is not
+//     set up and slots live in the red zone below %rsp,
+// and rewrites the slot and parameter addresses to match.
+class FrameLayout {
+public:
+    static constexpr const char* kEnterMarker = "    @frame_enter ";
+    static constexpr const char* kTeardownMarker = "    @frame_teardown\n";
+    static constexpr int kRedZoneBytes = 128;
+
+    static std::string enter(int slotBytes) {
+        return kEnterMarker + std::to_string(slotBytes) + "\n";
+    }
+
+    // Replaces the markers of every function in `assembly` with its frame code
+    static std::string lower(const std::string& assembly, bool keepFramePointer) {
+        const std::string enterMarker = kEnterMarker;
+        const std::string teardownMarker = kTeardownMarker;
+        std::string result;
+        size_t pos = 0;
+        for (size_t enter = assembly.find(enterMarker); enter != std::string::npos;
+             enter = assembly.find(enterMarker, pos)) {
+            result += assembly.substr(pos, enter - pos);
+            size_t start = assembly.find('\n', enter) + 1;
+            int slotBytes = std::stoi(assembly.substr(enter + enterMarker.size()));
+            pos = std::min(assembly.find(enterMarker, start), assembly.size());
+            std::string function = assembly.substr(start, pos - start);
+            // The body ends with the last teardown; out-of-line stubs after its
+            // ret never return and do not count against the red zone
+            size_t last = function.rfind(teardownMarker);
+            size_t bodyEnd = last == std::string::npos ? function.size() : last + teardownMarker.size();
+            FrameLayout frame(function.substr(0, bodyEnd), slotBytes, keepFramePointer);
+            result += frame.prologue() + frame.relocate(function);
+        }
+        return result + assembly.substr(pos);
+    }
+
+    FrameLayout(const std::string& body, int slotBytes, bool keepFramePointer) : slotBytes(slotBytes) {
+        static const char* const calleeSaved[] = {"%rbx", "%r12", "%r13", "%r14", "%r15"};
+        bool movesStack = false;
+        bool usesFramePointer = false;
+        std::istringstream lines(body);
+        std::string line;
+        while (std::getline(lines, line)) {
+            line = line.substr(0, line.find('#'));
+            for (int i = 0; i < 5; i++) {
+                if (usesRegister(line, calleeSaved[i])) used[i] = true;
+            }
+            std::string mnemonic = firstWord(line);
+            if (mnemonic == "call" || mnemonic == "push" || mnemonic == "pushq" || mnemonic == "pop" ||
+                mnemonic == "popq" || usesRegister(line, "%rsp")) {
+                movesStack = true;
+            }
+            for (size_t pos = line.find("%rbp"); pos != std::string::npos; pos = line.find("%rbp", pos + 1)) {
+                if (pos == 0 || line[pos - 1] != '(') usesFramePointer = true;
+            }
+        }
+        for (int i = 0; i < 5; i++) {
+            if (used[i]) saved.push_back(calleeSaved[i]);
+        }
+        savedBytes = 8 * static_cast<int>(saved.size());
+        frameless = !keepFramePointer && !movesStack && !usesFramePointer && savedBytes + slotBytes <= kRedZoneBytes;
+    }
+
+    bool isFrameless() const { return frameless; }
+
+    std::string prologue() const {
+        std::ostringstream out;
+        if (frameless) {
+            // Leaf function: registers and slots stay in the red zone below %rsp
+            for (size_t i = 0; i < saved.size(); i++) {
+                out << "    mov " << saved[i] << ", -" << 8 * (i + 1) << "(%rsp)\n";
+            }
+            return out.str();
+        }
+        out << "    push %rbp\n";
+        out << "    mov %rsp, %rbp\n";
+        for (const auto& reg : saved) {
+            out << "    push " << reg << "\n";
+        }
+        // The pushes and the slots together keep %rsp 16-byte aligned
+        int reserve = ((savedBytes + slotBytes + 15) & ~15) - savedBytes;
+        if (reserve > 0) out << "    sub $" << reserve << ", %rsp  # Allocate stack space for local variables\n";
+        return out.str();
+    }
+
+    // The body with its slot and parameter addresses moved to this layout and the
+    // teardown markers expanded
+    std::string relocate(const std::string& body) const {
+        std::string result;
+        result.reserve(body.size());
+        std::string marker = kTeardownMarker;
+        size_t start = 0;
+        while (start < body.size()) {
+            size_t end = body.find('\n', start);
+            end = end == std::string::npos ? body.size() : end + 1;
+            std::string line = body.substr(start, end - start);
+            start = end;
+            if (line == marker) {
+                result += teardown();
+            } else {
+                result += relocateLine(line);
+            }
+        }
+        return result;
+    }
+
+private:
+    int slotBytes;
+    int savedBytes = 0;
+    bool used[5] = {};
+    std::vector<std::string> saved;  // In push order
+    bool frameless = false;
+
+    // Leaves %rsp at the return address, with the callee-saved registers restored
+    std::string teardown() const {
+        std::ostringstream out;
+        if (frameless) {
+            for (size_t i = 0; i < saved.size(); i++) {
+                out << "    mov -" << 8 * (i + 1) << "(%rsp), " << saved[i] << "\n";
+            }
+            return out.str();
+        }
+        if (saved.empty()) {
+            out << "    leave  # Release locals and temporaries\n";
+            return out.str();
+        }
+        out << "    lea -" << savedBytes << "(%rbp), %rsp  # Release locals and temporaries\n";
+        for (size_t i = saved.size(); i-- > 0;) {
+            out << "    pop " << saved[i] << "\n";
+        }
+        out << "    pop %rbp\n";
+        return out.str();
+    }
+
+    // Rewrites each D(%rbp) in the instruction part of a line
+    std::string relocateLine(const std::string& line) const {
+        size_t comment = line.find('#');
+        std::string code = line.substr(0, comment);
+        size_t pos = code.find("(%rbp)");
+        if (pos == std::string::npos) return line;
+
+        std::string out;
+        size_t copied = 0;
+        for (; pos != std::string::npos; pos = code.find("(%rbp)", pos + 6)) {
+            size_t begin = pos;
+            while (begin > 0 && std::isdigit(static_cast<unsigned char>(code[begin - 1]))) begin--;
+            if (begin > 0 && code[begin - 1] == '-') begin--;
+            long displacement = begin == pos ? 0 : std::stol(code.substr(begin, pos - begin));
+            out += code.substr(copied, begin - copied);
+            if (displacement < 0) {
+                // A slot, below the saved registers
+                displacement -= savedBytes;
+            } else if (frameless) {
+                // A stack parameter: no %rbp was pushed above the return address
+                displacement -= 8;
+            }
+            out += std::to_string(displacement) + (frameless ? "(%rsp)" : "(%rbp)");
+            copied = pos + 6;
+        }
+        out += code.substr(copied);
+        if (comment != std::string::npos) out += line.substr(comment);
+        return out;
+    }
+
+    static std::string firstWord(const std::string& line) {
+        size_t begin = line.find_first_not_of(" \t");
+        if (begin == std::string::npos) return "";
+        size_t end = line.find_first_of(" \t", begin);
+        return line.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+    }
+
+    // Whether a line names any part of a 64-bit register: %rbx also matches
+    // %ebx/%bx/%bl/%bh, %r12 also matches %r12d/%r12w/%r12b
+    static bool usesRegister(const std::string& line, const std::string& reg) {
+        bool numbered = std::isdigit(static_cast<unsigned char>(reg[2]));
+        std::vector<std::string> names = {reg};
+        if (!numbered) {
+            std::string base = reg.substr(2);  // "bx", "sp"
+            names.push_back("%e" + base);
+            names.push_back("%" + base);
+            if (base == "sp") {
+                names.push_back("%spl");
+            } else {
+                names.push_back("%" + base.substr(0, 1) + "l");
+                names.push_back("%" + base.substr(0, 1) + "h");
+            }
+        }
+        for (const auto& name : names) {
+            for (size_t pos = line.find(name); pos != std::string::npos; pos = line.find(name, pos + 1)) {
+                size_t end = pos + name.size();
+                if (end == line.size()) return true;
+                unsigned char next = static_cast<unsigned char>(line[end]);
+                if (numbered ? !std::isdigit(next) : !std::isalnum(next)) return true;
+            }
+        }
+        return false;
+    }
+};
+
+} // namespace orion
+
+#endif // FRAME_LAYOUT_H
@@ -0,0 +1,218 @@
+#ifndef INLINER_H
+#define INLINER_H
+
+#include "ast.h"
+#include "ast_walker.h"
+#include "profile.h"
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace orion {
+
+// Decides which user function calls the code generator expands inline.
+// Small functions are inlined everywhere, functions with a single call site are
+// inlined up to a larger size, and call sites inside loops get a bigger budget
+// since they run more often. With a profile, call sites that never ran only get
+// tiny functions and the hottest call sites get a large budget. Recursive
+// functions always stay out of line.
+class InlineCostModel {
+public:
+    // Resolves a call by name from inside the given function scope ("" for top level)
+    using Resolver = std::function<FunctionDeclaration*(const std::string& name, const std::string& scope)>;
+
+    static constexpr int kBaseBudget = 20;        // AST nodes inlined at any call site
+    static constexpr int kLoopBonus = 15;         // Extra budget per enclosing loop
+    static constexpr int kMaxLoopBonusDepth = 3;
+    static constexpr int kSingleSiteBudget = 150; // Budget when the callee has only one call site
+    static constexpr int kColdSiteBudget = 5;     // Profiled call sites that never ran
+    static constexpr int kHotSiteBudget = 80;     // Profiled call sites run kHotCallCount times
+
+    void analyze(Program& program,
+                 const std::unordered_map<FunctionDeclaration*, std::string>& scopeNames,
+                 Resolver resolve, const Profile* profile = nullptr) {
+        functions.clear();
+        sites.clear();
+        inlineSites.clear();
+
+        CallSiteCollector collector(*this, scopeNames, resolve);
+        program.accept(collector);
+
+        for (auto& entry : scopeNames) {
+            FunctionInfo& info = functions[entry.first];
+            BodyScanner scanner(info);
+            if (entry.first->isSingleExpression) {
+                if (entry.first->expression) entry.first->expression->accept(scanner);
+            } else {
+                for (auto& stmt : entry.first->body) stmt->accept(scanner);
+            }
+        }
+
+        markRecursion();
+
+        for (const CallSite& site : sites) {
+            const FunctionInfo& callee = functions[site.callee];
+            if (callee.recursive || callee.hasNestedFunction || callee.hasGlobalStatement) {
+                continue;
+            }
+            int budget = kBaseBudget + kLoopBonus * std::min(site.loopDepth, kMaxLoopBonusDepth);
+            if (callee.callSites == 1) {
+                budget = std::max(budget, kSingleSiteBudget);
+            }
+            int64_t calls = profile ? profile->count(site.call) : -1;
+            if (calls == 0) {
+                budget = std::min(budget, kColdSiteBudget);
+            } else if (calls >= Profile::kHotCallCount) {
+                budget = std::max(budget, kHotSiteBudget);
+            }
+            if (callee.size <= budget) {
+                inlineSites.insert(site.call);
+            }
+        }
+    }
+
+    bool shouldInline(FunctionCall* call) const {
+        return inlineSites.count(call) != 0;
+    }
+
+    // User functions called directly from func's body
+    const std::unordered_set<FunctionDeclaration*>& calleesOf(FunctionDeclaration* func) {
+        return functions[func].callees;
+    }
+
+private:
+    struct FunctionInfo {
+        int size = 0;
+        int callSites = 0;
+        bool recursive = false;
+        bool hasNestedFunction = false;
+        bool hasGlobalStatement = false;
+        std::unordered_set<FunctionDeclaration*> callees;
+    };
+
+    struct CallSite {
+        FunctionCall* call;
+        FunctionDeclaration* callee;
+        int loopDepth;
+    };
+
+    std::unordered_map<FunctionDeclaration*, FunctionInfo> functions;
+    std::vector<CallSite> sites;
+    std::unordered_set<FunctionCall*> inlineSites;
+
+    // Records every resolvable user call with its loop depth and builds the call graph
+    class CallSiteCollector : public RecursiveASTVisitor {
+    public:
+        CallSiteCollector(InlineCostModel& model,
+                          const std::unordered_map<FunctionDeclaration*, std::string>& scopeNames,
+                          Resolver& resolve)
+            : model(model), scopeNames(scopeNames), resolve(resolve) {}
+
+        using RecursiveASTVisitor::visit;
+
+        void visit(FunctionCall& node) override {
+            RecursiveASTVisitor::visit(node);
+            FunctionDeclaration* callee = resolve(node.name, scope);
+            if (!callee) return;
+            model.sites.push_back({&node, callee, loopDepth});
+            model.functions[callee].callSites++;
+            if (current) model.functions[current].callees.insert(callee);
+        }
+
+        void visit(FunctionDeclaration& node) override {
+            auto it = scopeNames.find(&node);
+            if (it == scopeNames.end()) return;
+            FunctionDeclaration* savedCurrent = current;
+            std::string savedScope = scope;
+            int savedLoopDepth = loopDepth;
+            current = &node;
+            scope = it->second;
+            loopDepth = 0;
+            RecursiveASTVisitor::visit(node);
+            current = savedCurrent;
+            scope = savedScope;
+            loopDepth = savedLoopDepth;
+        }
+
+        void visit(WhileStatement& node) override {
+            loopDepth++;
+            RecursiveASTVisitor::visit(node);
+            loopDepth--;
+        }
+
+        void visit(ForInStatement& node) override {
+            node.iterable->accept(*this);
+            loopDepth++;
+            node.body->accept(*this);
+            loopDepth--;
+        }
+
+    private:
+        InlineCostModel& model;
+        const std::unordered_map<FunctionDeclaration*, std::string>& scopeNames;
+        Resolver& resolve;
+        FunctionDeclaration* current = nullptr;
+        std::string scope;
+        int loopDepth = 0;
+    };
+
+    // Measures a function body and notes constructs that make it unsafe to inline
+    class BodyScanner : public RecursiveASTVisitor {
+    public:
+        explicit BodyScanner(FunctionInfo& info) : info(info) {}
+
+        void visit(IntLiteral&) override { info.size++; }
+        void visit(FloatLiteral&) override { info.size++; }
+        void visit(StringLiteral&) override { info.size++; }
+        void visit(BoolLiteral&) override { info.size++; }
+        void visit(Identifier&) override { info.size++; }
+        void visit(InterpolatedString& node) override { info.size++; RecursiveASTVisitor::visit(node); }
+        void visit(BinaryExpression& node) override { info.size++; RecursiveASTVisitor::visit(node); }
+        void visit(UnaryExpression& node) override { info.size++; RecursiveASTVisitor::visit(node); }
+        void visit(FunctionCall& node) override { info.size++; RecursiveASTVisitor::visit(node); }
+        void visit(TupleExpression& node) override { info.size++; RecursiveASTVisitor::visit(node); }
+        void visit(ListLiteral& node) override { info.size++; RecursiveASTVisitor::visit(node); }
+        void visit(IndexExpression& node) override { info.size++; RecursiveASTVisitor::visit(node); }
+        void visit(VariableDeclaration& node) override { info.size++; RecursiveASTVisitor::visit(node); }
+        void visit(FunctionDeclaration&) override { info.hasNestedFunction = true; }
+        void visit(ExpressionStatement& node) override { info.size++; RecursiveASTVisitor::visit(node); }
+        void visit(TupleAssignment& node) override { info.size++; RecursiveASTVisitor::visit(node); }
+        void visit(ChainAssignment& node) override { info.size++; RecursiveASTVisitor::visit(node); }
+        void visit(IndexAssignment& node) override { info.size++; RecursiveASTVisitor::visit(node); }
+        void visit(GlobalStatement&) override { info.hasGlobalStatement = true; }
+        void visit(ReturnStatement& node) override { info.size++; RecursiveASTVisitor::visit(node); }
+        void visit(IfStatement& node) override { info.size++; RecursiveASTVisitor::visit(node); }
+        void visit(WhileStatement& node) override { info.size++; RecursiveASTVisitor::visit(node); }
+        void visit(ForInStatement& node) override { info.size++; RecursiveASTVisitor::visit(node); }
+
+    private:
+        FunctionInfo& info;
+    };
+
+    // A function is recursive if it can reach itself through the call graph
+    void markRecursion() {
+        for (auto& entry : functions) {
+            std::unordered_set<FunctionDeclaration*> visited;
+            std::vector<FunctionDeclaration*> worklist(entry.second.callees.begin(), entry.second.callees.end());
+            while (!worklist.empty()) {
+                FunctionDeclaration* func = worklist.back();
+                worklist.pop_back();
+                if (func == entry.first) {
+                    entry.second.recursive = true;
+                    break;
+                }
+                if (!visited.insert(func).second) continue;
+                auto it = functions.find(func);
+                if (it == functions.end()) continue;
+                worklist.insert(worklist.end(), it->second.callees.begin(), it->second.callees.end());
+            }
+        }
+    }
+};
+
+} // namespace orion
+
+#endif // INLINER_H
@@ -0,0 +1,361 @@
+#ifndef LIST_ACCESS_H
+#define LIST_ACCESS_H
+
+#include "ast.h"
+#include "ast_walker.h"
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace orion {
+
+// Finds out whether a loop body may change the size or storage of a list it
+// iterates over. append/pop reallocate or shrink the element array, and a call to
+// a user function may do either through an alias, so both count. Element stores
+// (xs[i] = v) keep the array in place and do not.
+class ListResizeScanner : public RecursiveASTVisitor {
+public:
+    bool mayResize = false;
+
+    using RecursiveASTVisitor::visit;
+
+    void visit(FunctionCall& node) override {
+        if (!isNonResizingBuiltin(node.name)) mayResize = true;
+        RecursiveASTVisitor::visit(node);
+    }
+
+    // Declaring a function runs none of its body
+    void visit(FunctionDeclaration&) override {}
+
+private:
+    static bool isNonResizingBuiltin(const std::string& name) {
+        return name == "str" || name == "int" || name == "flt" || name == "len" ||
+               name == "range" || name == "out" || name == "input" || name == "dtype";
+    }
+};
+
+// Value-range analysis that proves list accesses in bounds so the code generator
+// can drop their checks. It tracks, flow-sensitively within each function body:
+//   - the minimum length of lists assigned a list literal
+//   - variables holding len(xs), for loops bounded by a hoisted length
+//   - range() loop variables known to lie in [0, len(xs)) or [0, limit)
+// An access xs[i] or xs[c] is proven when one of these facts covers it. pop() and
+// user function calls may shrink any list through an alias and forget all lengths.
+class BoundsCheckAnalysis {
+public:
+    void run(Program& program) {
+        proven.clear();
+
+        std::vector<FunctionDeclaration*> functions;
+        Walker topLevel(proven, functions);
+        program.accept(topLevel);
+
+        // Functions may run at any point, so each body starts with no facts
+        for (size_t i = 0; i < functions.size(); i++) {
+            Walker body(proven, functions);
+            FunctionDeclaration* func = functions[i];
+            if (func->isSingleExpression) {
+                if (func->expression) func->expression->accept(body);
+            } else {
+                for (auto& stmt : func->body) stmt->accept(body);
+            }
+        }
+    }
+
+    // True for IndexExpression / IndexAssignment nodes whose index is always in range
+    bool isProven(const ASTNode* access) const {
+        return proven.count(access) != 0;
+    }
+
+private:
+    std::unordered_set<const ASTNode*> proven;
+
+    // Values a range() loop variable can take: [0, len(list)) or [0, limit)
+    struct IndexRange {
+        std::string list;
+        int64_t limit = -1;
+
+        bool operator==(const IndexRange& other) const {
+            return list == other.list && limit == other.limit;
+        }
+    };
+
+    struct Facts {
+        std::map<std::string, int64_t> minLength;     // List -> elements it holds at least
+        std::map<std::string, std::string> lengthOf;  // Variable -> list whose length it holds
+        std::map<std::string, IndexRange> indexRange; // Loop variable -> values it takes
+
+        void forget(const std::string& name) {
+            minLength.erase(name);
+            lengthOf.erase(name);
+            indexRange.erase(name);
+            for (auto it = lengthOf.begin(); it != lengthOf.end();) {
+                it = it->second == name ? lengthOf.erase(it) : std::next(it);
+            }
+            for (auto it = indexRange.begin(); it != indexRange.end();) {
+                it = it->second.list == name ? indexRange.erase(it) : std::next(it);
+            }
+        }
+
+        // Lists may have shrunk: only loop variables bounded by a constant survive
+        void forgetLengths() {
+            minLength.clear();
+            lengthOf.clear();
+            for (auto it = indexRange.begin(); it != indexRange.end();) {
+                it = !it->second.list.empty() ? indexRange.erase(it) : std::next(it);
+            }
+        }
+
+        // Facts holding on both sides of a branch
+        void meet(const Facts& other) {
+            for (auto it = minLength.begin(); it != minLength.end();) {
+                auto found = other.minLength.find(it->first);
+                if (found == other.minLength.end()) {
+                    it = minLength.erase(it);
+                } else {
+                    it->second = std::min(it->second, found->second);
+                    ++it;
+                }
+            }
+            for (auto it = lengthOf.begin(); it != lengthOf.end();) {
+                auto found = other.lengthOf.find(it->first);
+                it = (found == other.lengthOf.end() || !(found->second == it->second)) ? lengthOf.erase(it) : std::next(it);
+            }
+            for (auto it = indexRange.begin(); it != indexRange.end();) {
+                auto found = other.indexRange.find(it->first);
+                it = (found == other.indexRange.end() || !(found->second == it->second)) ? indexRange.erase(it) : std::next(it);
+            }
+        }
+    };
+
+    // Whether running a statement may shrink a list: pop() or a user function call
+    class ShrinkScanner : public RecursiveASTVisitor {
+    public:
+        bool mayShrink = false;
+
+        using RecursiveASTVisitor::visit;
+
+        void visit(FunctionCall& node) override {
+            if (mayShrinkLists(node.name)) mayShrink = true;
+            RecursiveASTVisitor::visit(node);
+        }
+        void visit(FunctionDeclaration&) override {}
+    };
+
+    static bool mayShrinkLists(const std::string& name) {
+        return name != "str" && name != "int" && name != "flt" && name != "len" && name != "append" &&
+               name != "range" && name != "out" && name != "input" && name != "dtype";
+    }
+
+    class Walker : public RecursiveASTVisitor {
+    public:
+        Walker(std::unordered_set<const ASTNode*>& proven, std::vector<FunctionDeclaration*>& functions)
+            : proven(proven), functions(functions) {}
+
+        using RecursiveASTVisitor::visit;
+
+        void visit(FunctionDeclaration& node) override {
+            functions.push_back(&node);
+        }
+
+        void visit(FunctionCall& node) override {
+            RecursiveASTVisitor::visit(node);
+            if (mayShrinkLists(node.name)) facts.forgetLengths();
+        }
+
+        void visit(IndexExpression& node) override {
+            RecursiveASTVisitor::visit(node);
+            if (inBounds(node.object.get(), node.index.get())) proven.insert(&node);
+        }
+
+        void visit(IndexAssignment& node) override {
+            // The store happens after the value is evaluated, so judge with the facts after it
+            RecursiveASTVisitor::visit(node);
+            if (inBounds(node.object.get(), node.index.get())) proven.insert(&node);
+        }
+
+        void visit(VariableDeclaration& node) override {
+            RecursiveASTVisitor::visit(node);
+            facts.forget(node.name);
+            if (auto list = dynamic_cast<ListLiteral*>(node.initializer.get())) {
+                facts.minLength[node.name] = (int64_t)list->elements.size();
+            } else if (const std::string* list = lengthCallList(node.initializer.get())) {
+                if (*list != node.name) facts.lengthOf[node.name] = *list;
+            }
+        }
+
+        void visit(ChainAssignment& node) override {
+            RecursiveASTVisitor::visit(node);
+            for (const auto& name : node.variables) facts.forget(name);
+        }
+
+        void visit(TupleAssignment& node) override {
+            RecursiveASTVisitor::visit(node);
+            for (auto& target : node.targets) {
+                if (auto id = dynamic_cast<Identifier*>(target.get())) facts.forget(id->name);
+            }
+        }
+
+        void visit(GlobalStatement& node) override {
+            for (const auto& name : node.variables) facts.forget(name);
+        }
+
+        void visit(LocalStatement& node) override {
+            for (const auto& name : node.variables) facts.forget(name);
+        }
+
+        void visit(IfStatement& node) override {
+            node.condition->accept(*this);
+            Facts before = facts;
+            node.thenBranch->accept(*this);
+            Facts afterThen = facts;
+            facts = before;
+            if (node.elseBranch) node.elseBranch->accept(*this);
+            facts.meet(afterThen);
+        }
+
+        void visit(WhileStatement& node) override {
+            Facts entry = loopInvariantFacts(node.body.get(), nullptr);
+            facts = entry;
+            node.condition->accept(*this);
+            node.body->accept(*this);
+            facts = entry;
+        }
+
+        void visit(ForInStatement& node) override {
+            node.iterable->accept(*this);
+            Facts entry = loopInvariantFacts(node.body.get(), &node.variable);
+            facts = entry;
+
+            IndexRange range;
+            if (loopVariableRange(node, range)) facts.indexRange[node.variable] = range;
+            node.body->accept(*this);
+            facts = entry;
+        }
+
+    private:
+        std::unordered_set<const ASTNode*>& proven;
+        std::vector<FunctionDeclaration*>& functions;
+        Facts facts;
+        std::unordered_set<std::string> bodyAssigned; // Names the innermost loop body assigns
+        bool bodyMayShrink = false;
+
+        // Facts that hold on every iteration: drop what the body can change
+        Facts loopInvariantFacts(Statement* body, const std::string* loopVariable) {
+            bodyAssigned.clear();
+            AssignedNameCollector assigned(bodyAssigned);
+            body->accept(assigned);
+            if (loopVariable) bodyAssigned.insert(*loopVariable);
+
+            ShrinkScanner shrink;
+            body->accept(shrink);
+            bodyMayShrink = shrink.mayShrink;
+
+            Facts entry = facts;
+            if (bodyMayShrink) entry.forgetLengths();
+            for (const auto& name : bodyAssigned) entry.forget(name);
+            return entry;
+        }
+
+        // Values of a range() loop variable the body cannot disturb
+        bool loopVariableRange(ForInStatement& node, IndexRange& range) {
+            auto call = dynamic_cast<FunctionCall*>(node.iterable.get());
+            if (!call || call->name != "range" || call->arguments.empty() || call->arguments.size() > 3) {
+                return false;
+            }
+            if (bodyMayShrink) return false;
+            auto& args = call->arguments;
+            int64_t step = 1;
+            if (args.size() == 3 && !intConstant(args[2].get(), step)) return false;
+
+            if (step > 0) {
+                // [start, stop) with 0 <= start
+                int64_t start = 0;
+                if (args.size() >= 2 && (!intConstant(args[0].get(), start) || start < 0)) return false;
+                return upperBound(args.size() == 1 ? args[0].get() : args[1].get(), 0, range);
+            }
+            if (step < 0) {
+                // (stop, start] with -1 <= stop
+                int64_t stop = 0;
+                if (args.size() < 2 || !intConstant(args[1].get(), stop) || stop < -1) return false;
+                return upperBound(args[0].get(), 1, range);
+            }
+            return false;
+        }
+
+        // Bound for values below `expr + slack`: a constant, len(xs) or a variable
+        // holding it, optionally minus a constant
+        bool upperBound(Expression* expr, int64_t slack, IndexRange& range) {
+            int64_t offset = 0;
+            if (auto binary = dynamic_cast<BinaryExpression*>(expr)) {
+                if (binary->op != BinaryOp::SUB || !intConstant(binary->right.get(), offset) || offset < slack) {
+                    return false;
+                }
+                expr = binary->left.get();
+            } else if (slack > 0) {
+                int64_t limit = 0;
+                if (!intConstant(expr, limit)) return false;
+                range.limit = limit + slack;
+                return true;
+            }
+
+            int64_t limit = 0;
+            if (intConstant(expr, limit)) {
+                range.limit = std::max<int64_t>(limit - offset + slack, 0);
+                return true;
+            }
+            if (const std::string* list = lengthCallList(expr)) {
+                range.list = *list;
+            } else if (auto id = dynamic_cast<Identifier*>(expr)) {
+                auto it = facts.lengthOf.find(id->name);
+                if (it == facts.lengthOf.end()) return false;
+                range.list = it->second;
+            } else {
+                return false;
+            }
+            // The list must be the same one on every iteration
+            return !bodyAssigned.count(range.list);
+        }
+
+        bool inBounds(Expression* object, Expression* index) {
+            auto list = dynamic_cast<Identifier*>(object);
+            if (!list) return false;
+            auto length = facts.minLength.find(list->name);
+
+            int64_t constant = 0;
+            if (intConstant(index, constant)) {
+                return length != facts.minLength.end() && constant >= -length->second && constant < length->second;
+            }
+            auto id = dynamic_cast<Identifier*>(index);
+            if (!id) return false;
+            auto range = facts.indexRange.find(id->name);
+            if (range == facts.indexRange.end()) return false;
+            if (range->second.list == list->name) return true;
+            return range->second.list.empty() && length != facts.minLength.end() &&
+                   range->second.limit <= length->second;
+        }
+
+        static bool intConstant(Expression* expr, int64_t& value) {
+            if (auto literal = dynamic_cast<IntLiteral*>(expr)) {
+                value = literal->value;
+                return true;
+            }
+            return false;
+        }
+
+        // xs for `len(xs)`
+        static const std::string* lengthCallList(Expression* expr) {
+            auto call = dynamic_cast<FunctionCall*>(expr);
+            if (!call || call->name != "len" || call->arguments.size() != 1) return nullptr;
+            auto id = dynamic_cast<Identifier*>(call->arguments[0].get());
+            return id ? &id->name : nullptr;
+        }
+    };
+};
+
+} // namespace orion
+
+#endif // LIST_ACCESS_H
@@ -2,6 +2,21 @@
 #include "lexer.h"
 #include "simple_parser.h"
 #include "types.cpp"
+#include "inliner.h"
+#include "tailcall.h"
+#include "constant_folding.h"
+#include "dead_code.h"
+#include "list_access.h"
+#include "strength_reduction.h"
+#include "value_numbering.h"
+#include "vectorize.h"
+#include "unroll.h"
+#include "string_builder.h"
+#include "frame_layout.h"
+#include "profile.h"
+#include "partial_eval.h"
+#include "float_text.h"
+#include "peephole.h"
 #include <iostream>
 #include <fstream>
 #include <string>
@@ -13,6 +28,10 @@
 #include <sys/wait.h>
 #include <unistd.h>
 #include <unordered_set>
+#include <functional>
+#include <algorithm>
+#include <map>
+#include <set>
 #include <stack>
 
 namespace orion {
@@ -22,7 +41,10 @@ namespace orion {
 class SimpleCodeGenerator : public ASTVisitor {
 private:
     std::ostringstream assembly;      // For main execution code
-    std::ostringstream funcsAsm;      // For function definitions
+    std::vector<FunctionDeclaration*> generatedFunctions;               // In generation order
+    std::unordered_map<FunctionDeclaration*, std::string> functionAsm;  // Function -> its assembly
+    // Functions referenced by out-of-line calls from each function (nullptr: top-level code)
+    std::unordered_map<FunctionDeclaration*, std::unordered_set<FunctionDeclaration*>> functionCallees;
     std::vector<std::string> stringLiterals;
     std::vector<double> floatLiterals;
     struct VariableInfo {
@@ -45,10 +67,69 @@ private:
     
     std::unordered_map<std::string, FunctionScope> functionScopes; // Scope name -> functions in that scope
     std::vector<std::string> functionCallStack; // Track current function execution stack
+    std::unordered_map<FunctionDeclaration*, std::string> functionLabels; // Function -> assembly label
+    std::unordered_map<FunctionDeclaration*, std::string> functionScopeNames; // Function -> its own nested scope name
     
     int stackOffset = 0;
+    int maxStackOffset = 0;           // Deepest slot used by the frame being generated
     bool inFunction = false;
     int labelCounter = 0;
+    int stackDepth = 0;               // Bytes pushed below the frame for expression temporaries
+    std::string currentReturnLabel;   // Epilogue label of the function being generated
+    std::string currentReturnKind;    // Return value type observed in the function being generated
+    std::unordered_map<FunctionDeclaration*, std::string> functionReturnTypes; // Function -> return value type
+    
+    // Inline expansion of user function calls
+    InlineCostModel inlineCosts;
+    int inlineDepth = 0;
+    static constexpr int kMaxInlineDepth = 4;
+    
+    // Tail calls: self calls in return position jump back to the top of the body,
+    // pending `f(...) + e` / `f(...) * e` work is carried in an accumulator slot
+    FunctionDeclaration* currentFunction = nullptr; // Function being generated out of line
+    std::string currentBodyLabel;
+    std::vector<int> currentParamSlots;
+    int accumulatorSlot = 0;          // 0 when the function needs no accumulator
+    BinaryOp accumulatorOp = BinaryOp::ADD;
+    std::unordered_set<std::string> integerParameters;  // Of the function analyzeAccumulatorRecursion checks
+    
+    // List accesses proven in bounds need no check
+    BoundsCheckAnalysis boundsChecks;
+    
+    // Failed list bounds checks jump to one out-of-line stub per function
+    std::string indexErrorLabel;
+    bool indexErrorUsed = false;
+    
+    // Profile-guided optimization: the counters of the program, with their counts
+    // under --profile-use, and the branches a profile shows (almost) never run,
+    // placed after the code of the function being generated
+    Profile profile;
+    std::ostringstream coldBlocks;
+    
+    // Values kept in hidden slots for reuse: expressions computed before (CSE) and
+    // loop invariants computed ahead of the loop (LICM), by ValueKey
+    struct AvailableValue {
+        int slot;
+        std::vector<std::string> names;
+        bool readsLength;
+    };
+    std::map<std::string, AvailableValue> availableValues;
+    std::unordered_set<std::string> repeatedValues;  // Keys worth saving in the code being generated
+    Expression* valueBeingSaved = nullptr;
+    
+    // String variables the enclosing loops append to in place (startStringBuilders)
+    std::unordered_set<std::string> stringBuilders;
+    
+    // Variables of the code being generated that certainly hold a string, stored
+    // from text (isCertainString) on every path here; variables some function
+    // declares global never count, as a call could store anything in them
+    std::unordered_set<std::string> textVariables;
+    std::unordered_set<std::string> sharedGlobals;
+    // Whether each + and len() was generated for text, for the partial evaluator;
+    // nodes generated both ways in different copies are left out
+    std::unordered_map<Expression*, bool> textDecisions;
+    std::unordered_set<Expression*> mixedTextDecisions;
+    bool recordingText = true;
     
     // For managing nested loops and break/continue statements
     std::stack<std::string> breakLabels;
@@ -58,6 +139,720 @@ private:
         return prefix + std::to_string(labelCounter++);
     }
     
+    // Push/pop an expression temporary, keeping track of the stack depth so that
+    // calls can be emitted with a 16-byte aligned %rsp as the System V ABI requires
+    void pushTemp(const std::string& reg, const std::string& comment = "") {
+        assembly << "    push " << reg;
+        if (!comment.empty()) assembly << "  # " << comment;
+        assembly << "\n";
+        stackDepth += 8;
+    }
+    
+    void popTemp(const std::string& reg, const std::string& comment = "") {
+        assembly << "    pop " << reg;
+        if (!comment.empty()) assembly << "  # " << comment;
+        assembly << "\n";
+        stackDepth -= 8;
+    }
+    
+    static bool isBuiltinFunction(const std::string& name) {
+        return name == "str" || name == "int" || name == "flt" || name == "len" ||
+               name == "append" || name == "pop" || name == "range" || name == "out" ||
+               name == "input" || name == "dtype";
+    }
+    
+    // Undo a function prologue, leaving %rsp at the return address. Frames are laid
+    // out once the code is final, so this only marks the place for FrameLayout.
+    static void emitFrameTeardown(std::ostream& out) {
+        out << FrameLayout::kTeardownMarker;
+    }
+    
+    // Compiles a condition into a jump to `label` taken when its truth value equals
+    // jumpIfTrue, falling through otherwise. and/or/not become control flow and
+    // integer comparisons a cmp + jcc, without materialising a 0/1 value.
+    void emitBranch(Expression* condition, bool jumpIfTrue, const std::string& label) {
+        if (auto literal = dynamic_cast<BoolLiteral*>(condition)) {
+            if (literal->value == jumpIfTrue) assembly << "    jmp " << label << "\n";
+            return;
+        }
+        if (auto literal = dynamic_cast<IntLiteral*>(condition)) {
+            if ((literal->value != 0) == jumpIfTrue) assembly << "    jmp " << label << "\n";
+            return;
+        }
+        if (auto unary = dynamic_cast<UnaryExpression*>(condition)) {
+            if (unary->op == UnaryOp::NOT) {
+                emitBranch(unary->operand.get(), !jumpIfTrue, label);
+                return;
+            }
+        }
+        if (auto binary = dynamic_cast<BinaryExpression*>(condition)) {
+            if (binary->op == BinaryOp::AND || binary->op == BinaryOp::OR) {
+                bool isAnd = binary->op == BinaryOp::AND;
+                // Values computed by the right operand are not available when it is skipped
+                if (isAnd != jumpIfTrue) {
+                    // Either operand alone decides: false for `and`, true for `or`
+                    emitBranch(binary->left.get(), jumpIfTrue, label);
+                    auto skipped = availableValues;
+                    emitBranch(binary->right.get(), jumpIfTrue, label);
+                    meetAvailableValues(skipped);
+                } else {
+                    std::string skipLabel = newLabel("cond_skip_");
+                    emitBranch(binary->left.get(), !jumpIfTrue, skipLabel);
+                    auto skipped = availableValues;
+                    emitBranch(binary->right.get(), jumpIfTrue, label);
+                    meetAvailableValues(skipped);
+                    assembly << skipLabel << ":\n";
+                }
+                return;
+            }
+            if (isComparisonOp(binary->op) &&
+                (isFloatExpression(binary->left.get()) || isFloatExpression(binary->right.get()))) {
+                emitFloatBranch(*binary, jumpIfTrue, label);
+                return;
+            }
+            if (isComparisonOp(binary->op) && isIntegerComparison(*binary)) {
+                static const std::map<BinaryOp, std::pair<const char*, const char*>> jumps = {
+                    {BinaryOp::EQ, {"je", "jne"}}, {BinaryOp::NE, {"jne", "je"}},
+                    {BinaryOp::LT, {"jl", "jge"}}, {BinaryOp::LE, {"jle", "jg"}},
+                    {BinaryOp::GT, {"jg", "jle"}}, {BinaryOp::GE, {"jge", "jl"}},
+                };
+                auto constant = dynamic_cast<IntLiteral*>(binary->right.get());
+                binary->left->accept(*this);
+                if (constant) {
+                    assembly << "    cmp $" << constant->value << ", %rax\n";
+                } else {
+                    pushTemp("%rax");
+                    binary->right->accept(*this);
+                    popTemp("%rbx");
+                    assembly << "    cmp %rax, %rbx\n";
+                }
+                const auto& jump = jumps.at(binary->op);
+                assembly << "    " << (jumpIfTrue ? jump.first : jump.second) << " " << label << "\n";
+                return;
+            }
+        }
+        condition->accept(*this);
+        assembly << "    test %rax, %rax\n";
+        assembly << "    " << (jumpIfTrue ? "jnz " : "jz ") << label << "\n";
+    }
+    
+    static bool isComparisonOp(BinaryOp op) {
+        return op == BinaryOp::EQ || op == BinaryOp::NE || op == BinaryOp::LT ||
+               op == BinaryOp::LE || op == BinaryOp::GT || op == BinaryOp::GE;
+    }
+    
+    // Operands compared as signed integers (neither float nor both strings)
+    bool isIntegerComparison(BinaryExpression& node) {
+        if (inferExprKind(node.left.get()) == ExprKind::STRING && inferExprKind(node.right.get()) == ExprKind::STRING) {
+            return false;
+        }
+        return !isFloatExpression(node.left.get()) && !isFloatExpression(node.right.get());
+    }
+    
+    // Sets %al to the result of comparing %xmm0 with %xmm1; NaN compares unequal
+    // and unordered, as in Python
+    void emitFloatCompare(BinaryOp op) {
+        switch (op) {
+            case BinaryOp::EQ:
+                assembly << "    ucomisd %xmm1, %xmm0\n";
+                assembly << "    sete %al\n";
+                assembly << "    setnp %cl\n";
+                assembly << "    and %cl, %al\n";
+                break;
+            case BinaryOp::NE:
+                assembly << "    ucomisd %xmm1, %xmm0\n";
+                assembly << "    setne %al\n";
+                assembly << "    setp %cl\n";
+                assembly << "    or %cl, %al\n";
+                break;
+            case BinaryOp::LT:
+                assembly << "    ucomisd %xmm0, %xmm1\n";
+                assembly << "    seta %al\n";
+                break;
+            case BinaryOp::LE:
+                assembly << "    ucomisd %xmm0, %xmm1\n";
+                assembly << "    setae %al\n";
+                break;
+            case BinaryOp::GT:
+                assembly << "    ucomisd %xmm1, %xmm0\n";
+                assembly << "    seta %al\n";
+                break;
+            default:
+                assembly << "    ucomisd %xmm1, %xmm0\n";
+                assembly << "    setae %al\n";
+                break;
+        }
+    }
+    
+    // Float temporaries live on the same stack as integer ones
+    void pushFloatTemp(const std::string& reg = "%xmm0") {
+        assembly << "    sub $8, %rsp\n";
+        assembly << "    movsd " << reg << ", (%rsp)\n";
+        stackDepth += 8;
+    }
+    
+    void popFloatTemp(const std::string& reg) {
+        assembly << "    movsd (%rsp), " << reg << "\n";
+        assembly << "    add $8, %rsp\n";
+        stackDepth -= 8;
+    }
+    
+    // Call a C function with %rsp 16-byte aligned, whatever temporaries are pushed
+    void emitAlignedCall(const std::string& symbol) {
+        bool pad = stackDepth % 16 != 0;
+        if (pad) assembly << "    sub $8, %rsp  # Align stack for call\n";
+        assembly << "    call " << symbol << "\n";
+        if (pad) assembly << "    add $8, %rsp\n";
+    }
+    
+    // Operand that an SSE instruction can read directly for a float-valued leaf:
+    // a variable slot or a constant in the data section. Int variables are
+    // converted into %xmm1. Returns "" for anything that needs evaluating.
+    std::string floatOperand(Expression* expr) {
+        if (auto literal = dynamic_cast<FloatLiteral*>(expr)) {
+            return "float_" + std::to_string(addFloatLiteral(literal->value)) + "(%rip)";
+        }
+        if (auto literal = dynamic_cast<IntLiteral*>(expr)) {
+            return "float_" + std::to_string(addFloatLiteral(static_cast<double>(literal->value))) + "(%rip)";
+        }
+        if (auto id = dynamic_cast<Identifier*>(expr)) {
+            VariableInfo* var = lookupVariable(id->name);
+            if (var && var->type == "float") {
+                return "-" + std::to_string(var->stackOffset) + "(%rbp)";
+            }
+            if (var && (var->type == "int" || var->type == "bool")) {
+                assembly << "    cvtsi2sdq -" << var->stackOffset << "(%rbp), %xmm1  # " << id->name << " as float\n";
+                return "%xmm1";
+            }
+        }
+        if (expr != valueBeingSaved && inferExprKind(expr) == ExprKind::FLOAT) {
+            auto it = availableValues.find(ValueKey::of(expr).key);
+            if (it != availableValues.end()) return "-" + std::to_string(it->second.slot) + "(%rbp)";
+        }
+        return "";
+    }
+    
+    // Evaluates a numeric expression as a double into %xmm0, converting integer
+    // values. Float arithmetic, variables and constants never pass through %rax.
+    void emitFloat(Expression* expr) {
+        if (emitReusableValue(*expr, true)) return;
+        if (dynamic_cast<FloatLiteral*>(expr) || dynamic_cast<IntLiteral*>(expr) || dynamic_cast<Identifier*>(expr)) {
+            std::string operand = floatOperand(expr);
+            if (operand == "%xmm1") {
+                assembly << "    movapd %xmm1, %xmm0\n";
+                return;
+            }
+            if (!operand.empty()) {
+                assembly << "    movsd " << operand << ", %xmm0\n";
+                return;
+            }
+        }
+        if (auto unary = dynamic_cast<UnaryExpression*>(expr)) {
+            if (unary->op == UnaryOp::PLUS) {
+                emitFloat(unary->operand.get());
+                return;
+            }
+            if (unary->op == UnaryOp::MINUS) {
+                emitFloat(unary->operand.get());
+                assembly << "    xorpd float_sign_mask(%rip), %xmm0  # Negate\n";
+                return;
+            }
+        }
+        if (auto binary = dynamic_cast<BinaryExpression*>(expr)) {
+            if (!isComparisonOp(binary->op) && binary->op != BinaryOp::AND && binary->op != BinaryOp::OR &&
+                isFloatExpression(binary)) {
+                emitFloatArithmetic(*binary);
+                return;
+            }
+        }
+        if (auto call = dynamic_cast<FunctionCall*>(expr)) {
+            if (call->name == "flt" && call->arguments.size() == 1) {
+                emitFltCall(*call);
+                return;
+            }
+            if (!isBuiltinFunction(call->name) && isFloatExpression(call)) {
+                call->accept(*this);  // Float results are returned in %xmm0
+                return;
+            }
+        }
+        expr->accept(*this);
+        if (isFloatExpression(expr)) {
+            assembly << "    movq %rax, %xmm0\n";
+        } else {
+            assembly << "    cvtsi2sd %rax, %xmm0  # Int to float\n";
+        }
+    }
+    
+    // Left operand into %xmm0 and right into %xmm1. A complex right operand is
+    // evaluated with the left one spilled to the temporary stack.
+    void emitFloatOperands(Expression* left, Expression* right) {
+        emitFloat(left);
+        std::string operand = floatOperand(right);
+        if (!operand.empty()) {
+            if (operand != "%xmm1") assembly << "    movsd " << operand << ", %xmm1\n";
+            return;
+        }
+        pushFloatTemp();
+        emitFloat(right);
+        assembly << "    movapd %xmm0, %xmm1\n";
+        popFloatTemp("%xmm0");
+    }
+    
+    // Float +, -, *, /, //, % and ** with the result in %xmm0
+    void emitFloatArithmetic(BinaryExpression& node) {
+        static const std::map<BinaryOp, const char*> instructions = {
+            {BinaryOp::ADD, "addsd"}, {BinaryOp::SUB, "subsd"},
+            {BinaryOp::MUL, "mulsd"}, {BinaryOp::DIV, "divsd"},
+        };
+        auto instruction = instructions.find(node.op);
+        if (instruction != instructions.end()) {
+            emitFloat(node.left.get());
+            std::string operand = floatOperand(node.right.get());
+            if (operand.empty()) {
+                pushFloatTemp();
+                emitFloat(node.right.get());
+                assembly << "    movapd %xmm0, %xmm1\n";
+                popFloatTemp("%xmm0");
+                operand = "%xmm1";
+            }
+            assembly << "    " << instruction->second << " " << operand << ", %xmm0\n";
+            return;
+        }
+        
+        emitFloatOperands(node.left.get(), node.right.get());
+        switch (node.op) {
+            case BinaryOp::FLOOR_DIV:
+                assembly << "    divsd %xmm1, %xmm0\n";
+                emitAlignedCall("floor");
+                break;
+            case BinaryOp::MOD:
+                emitAlignedCall("fmod");
+                break;
+            case BinaryOp::POWER:
+                emitAlignedCall("pow");
+                break;
+            default:
+                throw std::runtime_error("Error: Unsupported operator for float operands");
+        }
+    }
+    
+    // flt(x) with the result in %xmm0
+    void emitFltCall(FunctionCall& node) {
+        Expression* argument = node.arguments[0].get();
+        ExprKind kind = inferExprKind(argument);
+        if (kind == ExprKind::INT || kind == ExprKind::FLOAT || kind == ExprKind::BOOL) {
+            emitFloat(argument);
+            return;
+        }
+        argument->accept(*this);
+        assembly << "    mov %rax, %rdi\n";
+        if (kind == ExprKind::STRING) {
+            emitAlignedCall("__orion_string_to_float");
+        } else {
+            emitAlignedCall("__orion_int_to_float");  // Unknown values are taken as integers
+        }
+    }
+    
+    // Float comparison as a jump. ucomisd sets PF for unordered operands (NaN),
+    // which compare unequal and fail every ordering.
+    void emitFloatBranch(BinaryExpression& node, bool jumpIfTrue, const std::string& label) {
+        emitFloatOperands(node.left.get(), node.right.get());
+        bool equality = node.op == BinaryOp::EQ || node.op == BinaryOp::NE;
+        if (equality) {
+            assembly << "    ucomisd %xmm1, %xmm0\n";
+            bool wantEqual = (node.op == BinaryOp::EQ) == jumpIfTrue;
+            if (wantEqual) {
+                std::string skipLabel = newLabel("fcmp_skip_");
+                assembly << "    jp " << skipLabel << "\n";
+                assembly << "    je " << label << "\n";
+                assembly << skipLabel << ":\n";
+            } else {
+                assembly << "    jp " << label << "\n";
+                assembly << "    jne " << label << "\n";
+            }
+            return;
+        }
+        // a < b and a <= b are tested as b > a and b >= a, so that an unordered
+        // result (CF=1) reads as false
+        bool swapped = node.op == BinaryOp::LT || node.op == BinaryOp::LE;
+        bool strict = node.op == BinaryOp::LT || node.op == BinaryOp::GT;
+        assembly << (swapped ? "    ucomisd %xmm0, %xmm1\n" : "    ucomisd %xmm1, %xmm0\n");
+        if (jumpIfTrue) {
+            assembly << "    " << (strict ? "ja " : "jae ") << label << "\n";
+        } else {
+            assembly << "    " << (strict ? "jbe " : "jb ") << label << "\n";
+        }
+    }
+    
+    // Integer `/`, `//`, `%` and `**` with a constant right operand: shifts and
+    // masks for powers of two, multiply-high for other divisors, and an unrolled
+    // square-and-multiply chain for exponents. Returns false to fall back to the
+    // general code (division by zero, negative exponents, other operators).
+    bool emitIntegerOpByConstant(BinaryExpression& node, int64_t value) {
+        bool division = node.op == BinaryOp::DIV || node.op == BinaryOp::FLOOR_DIV || node.op == BinaryOp::MOD;
+        if (!(division && value != 0) && !(node.op == BinaryOp::POWER && value >= 0)) {
+            return false;
+        }
+        node.left->accept(*this);
+        
+        if (node.op == BinaryOp::POWER) {
+            assembly << "    # x ** " << value << " by repeated squaring\n";
+            if (value == 0) {
+                assembly << "    mov $1, %rax\n";
+                return true;
+            }
+            assembly << "    mov %rax, %rcx\n";
+            int top = 62;
+            while (!((value >> top) & 1)) top--;
+            for (int bit = top - 1; bit >= 0; bit--) {
+                assembly << "    imul %rax, %rax\n";
+                if ((value >> bit) & 1) assembly << "    imul %rcx, %rax\n";
+            }
+            return true;
+        }
+        
+        if (value == 1 || value == -1) {
+            if (node.op == BinaryOp::MOD) {
+                assembly << "    xor %eax, %eax  # x % " << value << "\n";
+            } else if (value == -1) {
+                assembly << "    neg %rax  # x / -1\n";
+            }
+            return true;
+        }
+        
+        int shift = intmath::powerOfTwoShift(value);
+        if (shift > 0) {
+            switch (node.op) {
+                case BinaryOp::FLOOR_DIV:
+                    assembly << "    sar $" << shift << ", %rax  # x // " << value << "\n";
+                    break;
+                case BinaryOp::MOD:
+                    assembly << "    and $" << (value - 1) << ", %rax  # x % " << value << "\n";
+                    break;
+                default:
+                    // Truncating: bias negative dividends by value - 1 before shifting
+                    assembly << "    mov %rax, %rdx  # x / " << value << "\n";
+                    assembly << "    sar $63, %rdx\n";
+                    assembly << "    shr $" << (64 - shift) << ", %rdx\n";
+                    assembly << "    add %rdx, %rax\n";
+                    assembly << "    sar $" << shift << ", %rax\n";
+                    break;
+            }
+            return true;
+        }
+        
+        // Truncated quotient into %rdx, dividend kept in %rcx
+        intmath::DivisionMagic magic = intmath::signedDivisionMagic(value);
+        assembly << "    # x / " << value << " by multiply-high\n";
+        assembly << "    mov %rax, %rcx\n";
+        assembly << "    movabs $" << magic.multiplier << ", %rax\n";
+        assembly << "    imul %rcx\n";
+        if (value > 0 && magic.multiplier < 0) assembly << "    add %rcx, %rdx\n";
+        if (value < 0 && magic.multiplier > 0) assembly << "    sub %rcx, %rdx\n";
+        if (magic.shift > 0) assembly << "    sar $" << magic.shift << ", %rdx\n";
+        assembly << "    mov %rdx, %rax\n";
+        assembly << "    shr $63, %rax\n";
+        assembly << "    add %rax, %rdx\n";
+        if (node.op == BinaryOp::DIV) {
+            assembly << "    mov %rdx, %rax\n";
+            return true;
+        }
+        
+        // Remainder, then floor: adjust when it is non-zero and its sign differs from the divisor's
+        assembly << "    imul $" << value << ", %rdx, %rax\n";
+        assembly << "    mov %rcx, %rsi\n";
+        assembly << "    sub %rax, %rsi  # Remainder\n";
+        if (value > 0) {
+            assembly << "    mov %rsi, %rax\n";
+            assembly << "    sar $63, %rax  # -1 if the remainder is negative\n";
+        } else {
+            assembly << "    xor %eax, %eax\n";
+            assembly << "    test %rsi, %rsi\n";
+            assembly << "    setg %al\n";
+            assembly << "    neg %rax  # -1 if the remainder is positive\n";
+        }
+        if (node.op == BinaryOp::FLOOR_DIV) {
+            assembly << "    add %rdx, %rax\n";
+        } else {
+            assembly << "    and $" << value << ", %rax\n";
+            assembly << "    add %rsi, %rax\n";
+        }
+        return true;
+    }
+    
+    // Bounds check for an inline list access. Expects the list in %rcx and the index
+    // in %rax; a negative index is counted from the end. Leaves the checked index in
+    // %rax and the element array in %rcx. Clobbers %rdx and %rsi.
+    void emitListElementAccess(ASTNode& access, Expression* index) {
+        auto literal = dynamic_cast<IntLiteral*>(index);
+        if (boundsChecks.isProven(&access)) {
+            // Proven indices are non-negative unless they are constants
+            if (literal && literal->value < 0) {
+                assembly << "    add (%rcx), %rax  # Index from the end\n";
+            }
+            assembly << "    mov 16(%rcx), %rcx  # Element array (index proven in range)\n";
+            return;
+        }
+        assembly << "    mov (%rcx), %rdx  # List size\n";
+        if (literal && literal->value < 0) {
+            assembly << "    add %rdx, %rax  # Index from the end\n";
+        } else if (!literal) {
+            assembly << "    mov %rax, %rsi\n";
+            assembly << "    sar $63, %rsi\n";
+            assembly << "    and %rdx, %rsi\n";
+            assembly << "    add %rsi, %rax  # Negative index counts from the end\n";
+        }
+        // Unsigned compare also rejects indices still negative after adjusting
+        assembly << "    cmp %rdx, %rax\n";
+        assembly << "    jae " << indexErrorLabel << "\n";
+        assembly << "    mov 16(%rcx), %rcx  # Element array\n";
+        indexErrorUsed = true;
+    }
+    
+    // Out-of-line target of failed bounds checks, placed after the function's ret
+    void emitIndexErrorStub(std::ostream& out) {
+        if (!indexErrorUsed) return;
+        // Profiled code keeps error paths away from the hot code
+        if (profile.hasCounts()) out << "    .pushsection .text.unlikely, \"ax\", @progbits\n";
+        out << indexErrorLabel << ":\n";
+        out << "    and $-16, %rsp\n";
+        out << "    call orion_list_index_error\n";
+        if (profile.hasCounts()) out << "    .popsection\n";
+    }
+    
+    // --profile-generate: the instruction counting one execution of a counted point
+    std::string profileCount(ASTNode* node, int offset = 0) const {
+        int index = profile.counter(node, offset);
+        if (profileGeneratePath.empty() || index < 0) return "";
+        return "    incq profile_counts+" + std::to_string(8 * index) + "(%rip)\n";
+    }
+    
+    // Places the cold branches of the function just generated in .text.unlikely
+    void flushColdBlocks(std::ostream& out) {
+        std::string blocks = coldBlocks.str();
+        coldBlocks.str("");
+        coldBlocks.clear();
+        if (blocks.empty()) return;
+        out << "    .pushsection .text.unlikely, \"ax\", @progbits\n";
+        out << blocks;
+        out << "    .popsection\n";
+    }
+    
+    // An if statement one of whose branches the profile shows (almost) never runs:
+    // the hot branch falls through and the cold one is generated into coldBlocks,
+    // from where it jumps back
+    void emitIfWithColdBranch(IfStatement& node, bool coldThen) {
+        std::string coldLabel = newLabel("cold_");
+        std::string resumeLabel = newLabel("resume_");
+        Statement* hot = coldThen ? node.elseBranch.get() : node.thenBranch.get();
+        Statement* cold = coldThen ? node.thenBranch.get() : node.elseBranch.get();
+        
+        emitBranch(node.condition.get(), coldThen, coldLabel);
+        auto beforeBranches = availableValues;
+        auto textBefore = textVariables;
+        if (hot) {
+            if (!coldThen) assembly << profileCount(&node, Profile::Taken);
+            hot->accept(*this);
+        }
+        auto afterHot = availableValues;
+        auto textAfterHot = textVariables;
+        
+        std::string hotCode = assembly.str();
+        assembly.str("");
+        assembly.clear();
+        availableValues = beforeBranches;
+        textVariables = textBefore;
+        assembly << coldLabel << ":\n";
+        if (coldThen) assembly << profileCount(&node, Profile::Taken);
+        cold->accept(*this);
+        assembly << "    jmp " << resumeLabel << "\n";
+        coldBlocks << assembly.str();
+        assembly.str("");
+        assembly.clear();
+        assembly << hotCode;
+        
+        meetAvailableValues(afterHot);
+        meetTextVariables(textAfterHot);
+        assembly << resumeLabel << ":\n";
+    }
+    
+    // Loads a value that is already available into %rax (%xmm0 with asFloat), or
+    // computes one that occurs again later and saves it. Returns false to let the
+    // caller generate the expression as usual.
+    bool emitReusableValue(Expression& expr, bool asFloat = false) {
+        if (&expr == valueBeingSaved) return false;
+        ValueKey value = ValueKey::of(&expr);
+        if (value.key.empty()) return false;
+        // Slots hold values as the expression's kind has them: doubles for floats
+        ExprKind kind = inferExprKind(&expr);
+        if (kind != ExprKind::INT && kind != ExprKind::FLOAT) return false;
+        if (asFloat && kind != ExprKind::FLOAT) return false;
+        auto it = availableValues.find(value.key);
+        if (it != availableValues.end()) {
+            assembly << "    " << (asFloat ? "movsd -" : "mov -") << it->second.slot << "(%rbp), "
+                     << (asFloat ? "%xmm0" : "%rax") << "  # Reuse " << value.key << "\n";
+            return true;
+        }
+        if (!repeatedValues.count(value.key)) return false;
+        saveValue(expr, value, asFloat);
+        return true;
+    }
+    
+    // Generate expr and keep its value in a new hidden slot
+    void saveValue(Expression& expr, const ValueKey& value, bool asFloat) {
+        Expression* saved = valueBeingSaved;
+        valueBeingSaved = &expr;
+        if (asFloat) {
+            emitFloat(&expr);
+        } else {
+            expr.accept(*this);
+        }
+        valueBeingSaved = saved;
+        int slot = allocateStackSlot();
+        assembly << "    " << (asFloat ? "movsd %xmm0" : "mov %rax") << ", -" << slot << "(%rbp)  # Keep "
+                 << value.key << "\n";
+        availableValues[value.key] = {slot, value.names, value.readsLength};
+    }
+    
+    // A variable was assigned: values computed from it are stale
+    void forgetValuesOf(const std::string& name) {
+        for (auto it = availableValues.begin(); it != availableValues.end();) {
+            const auto& names = it->second.names;
+            bool stale = std::find(names.begin(), names.end(), name) != names.end();
+            it = stale ? availableValues.erase(it) : std::next(it);
+        }
+    }
+    
+    void forgetLengthValues() {
+        for (auto it = availableValues.begin(); it != availableValues.end();) {
+            it = it->second.readsLength ? availableValues.erase(it) : std::next(it);
+        }
+    }
+    
+    // Control flow join: only values computed on every incoming path survive
+    void meetAvailableValues(const std::map<std::string, AvailableValue>& other) {
+        for (auto it = availableValues.begin(); it != availableValues.end();) {
+            auto found = other.find(it->first);
+            bool kept = found != other.end() && found->second.slot == it->second.slot;
+            it = kept ? std::next(it) : availableValues.erase(it);
+        }
+    }
+    
+    // Loop preheader: drop values the loop may change, then compute the loop's
+    // invariant expressions once so every iteration reuses them
+    void enterLoop(Statement* body, Expression* condition, const std::string* loopVariable) {
+        std::unordered_set<std::string> assigned;
+        AssignedNameCollector collector(assigned);
+        body->accept(collector);
+        if (loopVariable) assigned.insert(*loopVariable);
+        
+        CallEffectScanner effects;
+        body->accept(effects);
+        if (condition) condition->accept(effects);
+        if (effects.callsUserFunction) {
+            availableValues.clear();
+            return;
+        }
+        if (effects.resizesLists) forgetLengthValues();
+        for (const auto& name : assigned) forgetValuesOf(name);
+        
+        LoopInvariantScanner invariants(assigned, effects.resizesLists);
+        if (condition) condition->accept(invariants);
+        body->accept(invariants);
+        for (Expression* expr : invariants.invariants) {
+            ValueKey value = ValueKey::of(expr);
+            if (availableValues.count(value.key)) continue;
+            ExprKind kind = inferExprKind(expr);
+            if (kind != ExprKind::INT && kind != ExprKind::FLOAT) continue;
+            assembly << "    # Loop invariant: " << value.key << "\n";
+            saveValue(*expr, value, kind == ExprKind::FLOAT);
+        }
+    }
+    
+    // Loop preheader: each string the loop builds up with s = s + x, and lets
+    // nothing else keep, becomes a private copy with spare room that the appends
+    // grow in place. Returns the variables started here; a builder started by an
+    // enclosing loop carries on through this one.
+    std::vector<std::string> startStringBuilders(Statement* body, Expression* condition, const std::string* loopVariable) {
+        StringAccumulatorScanner scanner(loopVariable);
+        body->accept(scanner);
+        if (condition) condition->accept(scanner);
+        CallEffectScanner effects;
+        body->accept(effects);
+        if (condition) condition->accept(effects);
+        
+        std::vector<std::string> started;
+        for (const auto& entry : scanner.accumulators()) {
+            const std::string& name = entry.first;
+            VariableInfo* varInfo = lookupVariable(name);
+            if (!varInfo || varInfo->type != "string" || stringBuilders.count(name)) continue;
+            if (varInfo->isGlobal && effects.callsUserFunction) continue;  // The callee may keep it
+            bool concatenates = std::all_of(entry.second.begin(), entry.second.end(),
+                                            [&](BinaryExpression* append) { return isStringConcat(append); });
+            if (!concatenates) continue;
+            assembly << "    # String builder: " << name << "\n";
+            assembly << "    mov -" << varInfo->stackOffset << "(%rbp), %rdi\n";
+            emitAlignedCall("orion_sb_from");
+            assembly << "    mov %rax, -" << varInfo->stackOffset << "(%rbp)  # " << name << " = private copy\n";
+            forgetValuesOf(name);
+            stringBuilders.insert(name);
+            started.push_back(name);
+        }
+        return started;
+    }
+    
+    void stopStringBuilders(const std::vector<std::string>& started) {
+        for (const auto& name : started) stringBuilders.erase(name);
+    }
+    
+    // s = s + x inside a loop that keeps a builder for s
+    BinaryExpression* stringBuilderAppend(VariableDeclaration& node) {
+        if (!stringBuilders.count(node.name)) return nullptr;
+        auto binary = dynamic_cast<BinaryExpression*>(node.initializer.get());
+        if (!binary || !isStringConcat(binary)) return nullptr;
+        auto left = dynamic_cast<Identifier*>(binary->left.get());
+        return left && left->name == node.name ? binary : nullptr;
+    }
+    
+    // Keys of the expressions a function body (or the top-level code) repeats
+    static std::unordered_set<std::string> findRepeatedValues(const std::vector<std::unique_ptr<Statement>>& statements) {
+        std::vector<Statement*> code;
+        for (auto& stmt : statements) code.push_back(stmt.get());
+        RepeatedValueCounter counter;
+        return counter.run(code);
+    }
+    
+    // Targets of call instructions that are not defined in the generated code
+    std::set<std::string> externalCalls(const std::string& code) {
+        std::unordered_set<std::string> defined;
+        for (const auto& entry : functionLabels) {
+            defined.insert(entry.second);
+        }
+        std::set<std::string> symbols;
+        std::istringstream lines(code);
+        std::string line;
+        while (std::getline(lines, line)) {
+            size_t pos = line.find_first_not_of(' ');
+            if (pos == std::string::npos || line.compare(pos, 5, "call ") != 0) continue;
+            size_t begin = pos + 5;
+            size_t end = line.find_first_of(" \t#", begin);
+            std::string symbol = line.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+            if (!symbol.empty() && !defined.count(symbol)) {
+                symbols.insert(symbol);
+            }
+        }
+        return symbols;
+    }
+    
+    // Reserve the next 8-byte variable slot in the current frame and return its offset
+    int allocateStackSlot() {
+        stackOffset += 8;
+        if (stackOffset > maxStackOffset) {
+            maxStackOffset = stackOffset;
+        }
+        return stackOffset;
+    }
+    
     void setVariable(const std::string& varName, const std::string& valueRegister) {
         setVariable(varName, valueRegister, "unknown");
     }
@@ -68,7 +863,7 @@ private:
         
         if (varInfo == nullptr) {
             // Create new variable with proper scoping
-            stackOffset += 8;
+            allocateStackSlot();
             VariableInfo newVarInfo;
             newVarInfo.stackOffset = stackOffset;
             newVarInfo.type = varType;
@@ -93,18 +888,13 @@ private:
         }
         
         // Store value from register to variable's stack slot
+        forgetValuesOf(varName);
+        noteStore(varName, false);
         assembly << "    mov " << valueRegister << ", -" << varInfo->stackOffset << "(%rbp)  # " << varName << " = " << valueRegister << " (type: " << varInfo->type << ")\n";
     }
     
     bool isFloatExpression(Expression* expr) {
-        if (auto floatLit = dynamic_cast<FloatLiteral*>(expr)) {
-            return true;
-        }
-        if (auto id = dynamic_cast<Identifier*>(expr)) {
-            auto varInfo = lookupVariable(id->name);
-            return varInfo && varInfo->type == "float";
-        }
-        return false;
+        return inferExprKind(expr) == ExprKind::FLOAT;
     }
     
     // Expression kind inference for type safety
@@ -123,6 +913,9 @@ private:
         if (auto strLit = dynamic_cast<StringLiteral*>(expr)) {
             return ExprKind::STRING;
         }
+        if (dynamic_cast<InterpolatedString*>(expr)) {
+            return ExprKind::STRING;
+        }
         if (auto listLit = dynamic_cast<ListLiteral*>(expr)) {
             return ExprKind::LIST;
         }
@@ -136,7 +929,34 @@ private:
                 if (var->type == "list") return ExprKind::LIST;
             }
         }
+        if (auto call = dynamic_cast<FunctionCall*>(expr)) {
+            if (call->name == "len") {
+                isLengthOfText(*call);
+                return ExprKind::INT;
+            }
+            if (call->name == "int") return ExprKind::INT;
+            if (call->name == "str") return ExprKind::STRING;
+            if (call->name == "flt") return ExprKind::FLOAT;
+            FunctionDeclaration* func = findFunction(call->name);
+            if (func) {
+                auto it = functionReturnTypes.find(func);
+                if (it != functionReturnTypes.end()) {
+                    if (it->second == "int") return ExprKind::INT;
+                    if (it->second == "float") return ExprKind::FLOAT;
+                    if (it->second == "bool") return ExprKind::BOOL;
+                    if (it->second == "string") return ExprKind::STRING;
+                    if (it->second == "list") return ExprKind::LIST;
+                }
+            }
+        }
+        if (auto unary = dynamic_cast<UnaryExpression*>(expr)) {
+            if (unary->op == UnaryOp::NOT) return ExprKind::BOOL;
+            return inferExprKind(unary->operand.get());
+        }
         if (auto binExpr = dynamic_cast<BinaryExpression*>(expr)) {
+            if (isComparisonOp(binExpr->op) || binExpr->op == BinaryOp::AND || binExpr->op == BinaryOp::OR) {
+                return ExprKind::BOOL;
+            }
             ExprKind leftKind = inferExprKind(binExpr->left.get());
             ExprKind rightKind = inferExprKind(binExpr->right.get());
             
@@ -144,6 +964,9 @@ private:
                 if (leftKind == ExprKind::LIST && rightKind == ExprKind::LIST) {
                     return ExprKind::LIST;  // List concatenation
                 }
+                if (isStringConcat(binExpr)) {
+                    return ExprKind::STRING;  // String concatenation
+                }
             }
             if (binExpr->op == BinaryOp::MUL) {
                 if ((leftKind == ExprKind::LIST && rightKind == ExprKind::INT) ||
@@ -161,6 +984,139 @@ private:
         return ExprKind::UNKNOWN;
     }
     
+    // string + string is concatenation when one side is certainly text: a
+    // literal, str(), input(), an interpolation, another concatenation or a
+    // variable stored from one of those. Untyped parameters and calls are typed
+    // "string" by default but mostly hold numbers, which + keeps adding.
+    bool isStringConcat(BinaryExpression* binary) {
+        if (binary->op != BinaryOp::ADD) return false;
+        bool text = inferExprKind(binary->left.get()) == ExprKind::STRING &&
+                    inferExprKind(binary->right.get()) == ExprKind::STRING &&
+                    (isCertainString(binary->left.get()) || isCertainString(binary->right.get()));
+        recordText(binary, text);
+        return text;
+    }
+    
+    // len() reads a string's header only for certain text; anything else is a list
+    bool isLengthOfText(FunctionCall& call) {
+        bool text = call.arguments.size() == 1 && isCertainString(call.arguments[0].get());
+        recordText(&call, text);
+        return text;
+    }
+    
+    void recordText(Expression* node, bool text) {
+        if (!recordingText) return;
+        auto entry = textDecisions.emplace(node, text);
+        if (!entry.second && entry.first->second != text) mixedTextDecisions.insert(node);
+    }
+    
+    // A store to a variable: it holds text from here when the value is text
+    void noteStore(const std::string& name, bool text) {
+        if (text && !sharedGlobals.count(name)) {
+            textVariables.insert(name);
+        } else {
+            textVariables.erase(name);
+        }
+    }
+    
+    // Control flow join: a variable holds text only if it does on every path
+    void meetTextVariables(const std::unordered_set<std::string>& other) {
+        for (auto it = textVariables.begin(); it != textVariables.end();) {
+            it = other.count(*it) ? std::next(it) : textVariables.erase(it);
+        }
+    }
+    
+    // Loop preheader: a variable holds text on every iteration only when each
+    // store the loop makes to it is text as well
+    void enterTextLoop(Statement* body, const std::string* loopVariable) {
+        TextStoreCollector stores;
+        body->accept(stores);
+        if (loopVariable) textVariables.erase(*loopVariable);
+        for (const auto& name : stores.otherStores) textVariables.erase(name);
+        recordingText = false;  // Stores are judged as of the loop entry, not where they run
+        for (bool changed = true; changed;) {
+            changed = false;
+            for (VariableDeclaration* decl : stores.declarations) {
+                if (textVariables.count(decl->name) && !isCertainString(decl->initializer.get())) {
+                    textVariables.erase(decl->name);
+                    changed = true;
+                }
+            }
+        }
+        recordingText = true;
+    }
+    
+    // The type dtype() reports for a literal argument, or "" for anything else
+    static std::string literalType(Expression* expr) {
+        if (dynamic_cast<IntLiteral*>(expr)) return "int";
+        if (dynamic_cast<FloatLiteral*>(expr)) return "float";
+        if (dynamic_cast<StringLiteral*>(expr)) return "string";
+        if (dynamic_cast<BoolLiteral*>(expr)) return "bool";
+        if (dynamic_cast<ListLiteral*>(expr)) return "list";
+        return "";
+    }
+    
+    // left + right through a runtime function taking both strings
+    void emitStringConcat(BinaryExpression& node, const std::string& function) {
+        node.left->accept(*this);
+        pushTemp("%rax", "Save first string");
+        node.right->accept(*this);
+        assembly << "    mov %rax, %rsi  # Second string as second argument\n";
+        popTemp("%rdi", "Restore first string");
+        emitAlignedCall(function);
+    }
+    
+    bool isCertainString(Expression* expr) {
+        if (dynamic_cast<StringLiteral*>(expr) || dynamic_cast<InterpolatedString*>(expr)) return true;
+        if (auto id = dynamic_cast<Identifier*>(expr)) return textVariables.count(id->name) > 0;
+        if (auto call = dynamic_cast<FunctionCall*>(expr)) return call->name == "str" || call->name == "input";
+        auto binary = dynamic_cast<BinaryExpression*>(expr);
+        return binary && isStringConcat(binary);
+    }
+    
+    std::string exprKindToType(ExprKind kind) {
+        switch (kind) {
+            case ExprKind::INT: return "int";
+            case ExprKind::FLOAT: return "float";
+            case ExprKind::BOOL: return "bool";
+            case ExprKind::STRING: return "string";
+            case ExprKind::LIST: return "list";
+            default: return "";
+        }
+    }
+    
+    // Text as the body of an assembler string: quotes, backslashes and control
+    // characters escaped, so the bytes come out exactly as given
+    static std::string escapeAsmString(const std::string& text) {
+        std::string escaped;
+        for (char c : text) {
+            unsigned char byte = static_cast<unsigned char>(c);
+            if (c == '"' || c == '\\') {
+                escaped += '\\';
+                escaped += c;
+            } else if (c == '\n') {
+                escaped += "\\n";
+            } else if (c == '\t') {
+                escaped += "\\t";
+            } else if (byte < 0x20 || byte == 0x7f) {
+                char octal[8];
+                snprintf(octal, sizeof octal, "\\%03o", byte);
+                escaped += octal;
+            } else {
+                escaped += c;
+            }
+        }
+        return escaped;
+    }
+    
+    // A string in the data section, laid out like the runtime's heap strings:
+    // length (up to the first NUL) and capacity in the 16 bytes before the text
+    static std::string stringData(const std::string& label, const std::string& text) {
+        size_t length = std::min(text.find('\0'), text.size());
+        return ".balign 8\n    .quad " + std::to_string(length) + ", " + std::to_string(length) + "\n" + label +
+               ": .string \"" + escapeAsmString(text) + "\"\n";
+    }
+    
     int addStringLiteral(const std::string& str) {
         stringLiterals.push_back(str);
         return stringLiterals.size() - 1;
@@ -172,6 +1128,24 @@ private:
     }
     
 public:
+    // --profile-generate: where the instrumented program writes its counts
+    std::string profileGeneratePath;
+    // --profile-use: the profile recorded by an instrumented build of the same source
+    std::string profileUsePath;
+    
+    // Return value types of the generated functions, for the partial evaluator
+    const std::unordered_map<FunctionDeclaration*, std::string>& returnTypes() const {
+        return functionReturnTypes;
+    }
+    
+    std::unordered_map<Expression*, bool> textUses() const {
+        std::unordered_map<Expression*, bool> uses;
+        for (const auto& entry : textDecisions) {
+            if (!mixedTextDecisions.count(entry.first)) uses.insert(entry);
+        }
+        return uses;
+    }
+    
     std::string generate(Program& program) {
         assembly.str("");
         assembly.clear();
@@ -182,9 +1156,32 @@ public:
         declaredGlobal.clear();
         declaredLocal.clear();
         constantVariables.clear();
+        generatedFunctions.clear();
+        functionAsm.clear();
+        functionCallees.clear();
+        textVariables.clear();
+        textDecisions.clear();
+        mixedTextDecisions.clear();
+        sharedGlobals.clear();
+        GlobalNameCollector globals(sharedGlobals);
+        program.accept(globals);
         inFunction = false;
         stackOffset = 0;
+        maxStackOffset = 0;
         labelCounter = 0;
+        indexErrorLabel = "main_index_error";
+        indexErrorUsed = false;
+        coldBlocks.str("");
+        coldBlocks.clear();
+        
+        // Counters are numbered alike when recording a profile and when using it
+        profile.number(program);
+        if (!profileUsePath.empty()) {
+            std::string error;
+            if (!profile.read(profileUsePath, error)) {
+                std::cerr << "Warning: " << error << ", optimizing without a profile" << std::endl;
+            }
+        }
         
         // Visit program to collect strings and generate code
         program.accept(*this);
@@ -194,80 +1191,81 @@ public:
         
         // Data section
         fullAssembly << ".section .data\n";
-        fullAssembly << "format_int: .string \"%d\\n\"\n";
-        fullAssembly << "format_str: .string \"%s\"\n";
-        fullAssembly << "format_float: .string \"%.2f\\n\"\n";
-        fullAssembly << "dtype_int: .string \"datatype: int\\n\"\n";
-        fullAssembly << "dtype_string: .string \"datatype: string\\n\"\n";
-        fullAssembly << "dtype_bool: .string \"datatype: bool\\n\"\n";
-        fullAssembly << "dtype_float: .string \"datatype: float\\n\"\n";
-        fullAssembly << "dtype_list: .string \"datatype: list\\n\"\n";
-        fullAssembly << "dtype_unknown: .string \"datatype: unknown\\n\"\n";
-        fullAssembly << "str_true: .string \"True\\n\"\n";
-        fullAssembly << "str_false: .string \"False\\n\"\n";
-        fullAssembly << "str_index_error: .string \"Index Error\\n\"\n";
+        for (const char* type : {"int", "string", "bool", "float", "list", "unknown"}) {
+            fullAssembly << stringData(std::string("dtype_") + type, std::string("datatype: ") + type + "\n");
+        }
+        fullAssembly << stringData("str_index_error", "Index Error\n");
         
         // String literals
         for (size_t i = 0; i < stringLiterals.size(); i++) {
-            fullAssembly << "str_" << i << ": .string \"" << stringLiterals[i] << "\"\n";
+            fullAssembly << stringData("str_" + std::to_string(i), stringLiterals[i]);
         }
         
+        // Execution counters and the profile file they are written to at exit
+        if (!profileGeneratePath.empty()) {
+            fullAssembly << ".balign 8\n";
+            fullAssembly << "profile_counts: .zero " << 8 * std::max(1, profile.counterCount()) << "\n";
+            fullAssembly << "profile_path: .string \"" << escapeAsmString(profileGeneratePath) << "\"\n";
+        }
+        
+        // Sign bit for float negation with xorpd, whose memory operand must be 16-byte aligned
+        fullAssembly << ".balign 16\n";
+        fullAssembly << "float_sign_mask: .quad 0x8000000000000000, 0\n";
+        
         // Add float literals  
         for (size_t i = 0; i < floatLiterals.size(); ++i) {
             fullAssembly << "float_" << i << ": .quad " << *reinterpret_cast<uint64_t*>(&floatLiterals[i]) << "\n";
         }
         
-        // Text section
-        fullAssembly << "\n.section .text\n";
-        fullAssembly << ".global main\n";
-        fullAssembly << ".extern printf\n";
-        fullAssembly << ".extern orion_malloc\n";
-        fullAssembly << ".extern orion_free\n";
-        fullAssembly << ".extern exit\n";
-        fullAssembly << ".extern fmod\n";
-        fullAssembly << ".extern pow\n";
-        fullAssembly << ".extern strcmp\n";
-        // Enhanced list runtime functions
-        fullAssembly << ".extern list_new\n";
-        fullAssembly << ".extern list_from_data\n";
-        fullAssembly << ".extern list_len\n";
-        fullAssembly << ".extern list_get\n";
-        fullAssembly << ".extern list_set\n";
-        fullAssembly << ".extern list_append\n";
-        fullAssembly << ".extern list_pop\n";
-        fullAssembly << ".extern list_insert\n";
-        fullAssembly << ".extern list_concat\n";
-        fullAssembly << ".extern list_repeat\n";
-        fullAssembly << ".extern list_extend\n";
-        fullAssembly << ".extern orion_input\n";
-        fullAssembly << ".extern orion_input_prompt\n";
-        // String conversion and concatenation functions
-        fullAssembly << ".extern int_to_string\n";
-        fullAssembly << ".extern float_to_string\n";
-        fullAssembly << ".extern bool_to_string\n";
-        fullAssembly << ".extern string_to_string\n";
-        fullAssembly << ".extern string_concat_parts\n\n";
-        
-        // Emit user-defined functions first
-        fullAssembly << funcsAsm.str();
-        
-        // Main function (C runtime entry point)
-        fullAssembly << "main:\n";
-        fullAssembly << "    push %rbp\n";
-        fullAssembly << "    mov %rsp, %rbp\n";
-        fullAssembly << "    sub $64, %rsp\n";  // Allocate 64 bytes of stack space for variables
-        
-        // Program code (top-level statements and calls)
-        fullAssembly << assembly.str();
+        // Only functions reachable through out-of-line calls from the top-level code
+        // are emitted; calls that were inlined or folded away need no body
+        std::unordered_set<FunctionDeclaration*> reachable;
+        std::vector<FunctionDeclaration*> worklist(functionCallees[nullptr].begin(), functionCallees[nullptr].end());
+        while (!worklist.empty()) {
+            FunctionDeclaration* func = worklist.back();
+            worklist.pop_back();
+            if (!reachable.insert(func).second) continue;
+            auto& callees = functionCallees[func];
+            worklist.insert(worklist.end(), callees.begin(), callees.end());
+        }
+        
+        // Functions the profiled runs never entered go to .text.unlikely
+        std::ostringstream code;
+        for (FunctionDeclaration* func : generatedFunctions) {
+            if (!reachable.count(func)) continue;
+            bool cold = profile.isColdFunction(func);
+            if (cold) code << "    .pushsection .text.unlikely, \"ax\", @progbits\n";
+            code << functionAsm[func];
+            if (cold) code << "    .popsection\n";
+        }
         
+        // Main function (C runtime entry point): program code (top-level statements
+        // and calls), then return 0
         // Note: User main function should be called explicitly by user code
         // Don't auto-call main function to allow main() to be used like any other function
+        code << "main:\n";
+        code << FrameLayout::enter(maxStackOffset);
+        if (!profileGeneratePath.empty()) {
+            code << "    lea profile_counts(%rip), %rdi\n";
+            code << "    mov $" << profile.counterCount() << ", %rsi\n";
+            code << "    movabs $0x" << std::hex << profile.numberingChecksum() << std::dec << ", %rdx\n";
+            code << "    lea profile_path(%rip), %rcx\n";
+            code << "    call orion_profile_start\n";
+        }
+        code << assembly.str();
+        flushColdBlocks(code);
+        code << "    mov $0, %rax\n";
+        emitFrameTeardown(code);
+        code << "    ret\n";
+        emitIndexErrorStub(code);
         
-        // Return 0
-        fullAssembly << "    mov $0, %rax\n";
-        fullAssembly << "    add $64, %rsp\n";  // Restore stack pointer
-        fullAssembly << "    pop %rbp\n";
-        fullAssembly << "    ret\n";
+        // Text section: declare only the runtime and libc symbols the code calls
+        fullAssembly << "\n.section .text\n";
+        fullAssembly << ".global main\n";
+        for (const auto& symbol : externalCalls(code.str())) {
+            fullAssembly << ".extern " << symbol << "\n";
+        }
+        fullAssembly << "\n" << code.str();
         
         return fullAssembly.str();
     }
@@ -276,15 +1274,20 @@ public:
         // First pass: collect all function definitions with proper scoping
         collectFunctions(node.statements, ""); // Start with global scope
         
+        // Decide which call sites get expanded inline
+        inlineCosts.analyze(node, functionScopeNames,
+            [this](const std::string& name, const std::string& scope) {
+                return isBuiltinFunction(name) ? nullptr : findFunctionInScope(name, scope);
+            }, &profile);
+        
+        boundsChecks.run(node);
+        
         // Second pass: generate assembly code for all collected functions
         generateFunctionAssembly();
         
         // Third pass: execute only non-function statements and function calls
-        for (auto& stmt : node.statements) {
-            if (dynamic_cast<FunctionDeclaration*>(stmt.get()) == nullptr) {
-                stmt->accept(*this);
-            }
-        }
+        repeatedValues = findRepeatedValues(node.statements);
+        generateStatements(node.statements, true);
         
         // Main function will be called from C main in generate() method
     }
@@ -300,9 +1303,18 @@ public:
                 functionScopes[currentScope].functions[func->name] = func;
                 assembly << "    # Function '" << func->name << "' defined in scope '" << currentScope << "'\n";
                 
+                // Every function gets its own label: fn_ prefix avoids collisions with C/runtime
+                // symbols, nested functions are qualified by their enclosing scope (fn_outer.inner)
+                std::string nestedScope = currentScope.empty() ? func->name : currentScope + "::" + func->name;
+                std::string label = "fn_" + nestedScope;
+                for (size_t pos = label.find("::"); pos != std::string::npos; pos = label.find("::", pos)) {
+                    label.replace(pos, 2, ".");
+                }
+                functionScopeNames[func] = nestedScope;
+                functionLabels[func] = label;
+                
                 // Recursively collect nested functions from this function's body with proper scope
                 if (!func->isSingleExpression) {
-                    std::string nestedScope = currentScope.empty() ? func->name : currentScope + "::" + func->name;
                     collectFunctions(func->body, nestedScope);
                 }
             } else if (auto block = dynamic_cast<BlockStatement*>(stmt.get())) {
@@ -312,189 +1324,423 @@ public:
         }
     }
     
+    // Type a parameter's slot is given; untyped parameters are treated as strings
+    static std::string parameterType(const Parameter& param) {
+        return param.type.toString() != "unknown" ? param.type.toString() : "string";
+    }
+    
+    // Where the System V ABI passes a parameter: floats take the next free %xmm
+    // register, everything else the next integer register, and the rest go on the
+    // stack in parameter order
+    struct ArgumentLocation {
+        bool isFloat;
+        std::string reg;      // Empty for stack arguments
+        int stackIndex;       // Eightbyte above the return address for stack arguments
+    };
+    
+    static std::vector<ArgumentLocation> classifyParameters(const FunctionDeclaration& func) {
+        static const char* const integerRegs[] = {"%rdi", "%rsi", "%rdx", "%rcx", "%r8", "%r9"};
+        std::vector<ArgumentLocation> locations;
+        int integers = 0, floats = 0, stackArgs = 0;
+        for (const auto& param : func.parameters) {
+            ArgumentLocation location{parameterType(param) == "float", "", -1};
+            if (location.isFloat && floats < 8) {
+                location.reg = "%xmm" + std::to_string(floats++);
+            } else if (!location.isFloat && integers < 6) {
+                location.reg = integerRegs[integers++];
+            } else {
+                location.stackIndex = stackArgs++;
+            }
+            locations.push_back(location);
+        }
+        return locations;
+    }
+    
+    // Evaluate an argument onto the temporary stack; float parameters receive a
+    // double even when the argument is an integer
+    void pushArgument(Expression* argument, bool isFloat, size_t index) {
+        if (isFloat) {
+            emitFloat(argument);
+            assembly << "    # Arg " << index << " (float)\n";
+            pushFloatTemp();
+        } else {
+            argument->accept(*this);
+            pushTemp("%rax", "Arg " + std::to_string(index));
+        }
+    }
+    
+    // Generation order placing callees ahead of their callers (recursion aside), so
+    // a call site knows the callee's return type, and with it the return register
+    std::vector<FunctionDeclaration*> functionsCalleesFirst() {
+        std::vector<FunctionDeclaration*> order;
+        std::unordered_set<FunctionDeclaration*> placed;
+        std::function<void(FunctionDeclaration*)> place = [&](FunctionDeclaration* func) {
+            if (!placed.insert(func).second) return;
+            for (FunctionDeclaration* callee : inlineCosts.calleesOf(func)) place(callee);
+            order.push_back(func);
+        };
+        for (const auto& scope : functionScopes) {
+            for (const auto& funcPair : scope.second.functions) place(funcPair.second);
+        }
+        return order;
+    }
+    
     void generateFunctionAssembly() {
         // Generate assembly code for all collected functions in separate buffer
-        for (const auto& scope : functionScopes) {
-            for (const auto& funcPair : scope.second.functions) {
-                const std::string& funcName = funcPair.first;
-                FunctionDeclaration* func = funcPair.second;
-                
-                // Use fn_ prefix to avoid collision with C main
-                std::string labelName = (funcName == "main") ? "fn_main" : funcName;
-                
-                funcsAsm << "\n" << labelName << ":\n";
-                funcsAsm << "    push %rbp\n";
-                funcsAsm << "    mov %rsp, %rbp\n";
-                funcsAsm << "    sub $64, %rsp  # Allocate stack space for local variables\n";
-                
-                // Save current state and enter function scope
-                bool wasInFunction = inFunction;
-                auto savedLocalVars = localVariables;
-                int savedStackOffset = stackOffset;
-                std::ostringstream* savedOutput = nullptr;
-                
-                // Temporarily redirect output to funcsAsm for function body
-                savedOutput = &assembly;
+        for (FunctionDeclaration* func : functionsCalleesFirst()) {
+            const std::string& funcName = func->name;
+            std::string labelName = functionLabels[func];
+            
+            // Save current state and enter function scope
+            bool wasInFunction = inFunction;
+            auto savedLocalVars = localVariables;
+            auto savedDeclaredGlobal = declaredGlobal;
+            auto savedDeclaredLocal = declaredLocal;
+            int savedStackOffset = stackOffset;
+            int savedMaxStackOffset = maxStackOffset;
+            int savedStackDepth = stackDepth;
+            std::string savedReturnLabel = currentReturnLabel;
+            std::string savedReturnKind = currentReturnKind;
+            FunctionDeclaration* savedFunction = currentFunction;
+            std::string savedBodyLabel = currentBodyLabel;
+            auto savedParamSlots = currentParamSlots;
+            int savedAccumulatorSlot = accumulatorSlot;
+            BinaryOp savedAccumulatorOp = accumulatorOp;
+            std::string savedIndexErrorLabel = indexErrorLabel;
+            bool savedIndexErrorUsed = indexErrorUsed;
+            auto savedAvailableValues = availableValues;
+            auto savedRepeatedValues = repeatedValues;
+            auto savedStringBuilders = stringBuilders;
+            auto savedTextVariables = textVariables;
+            
+            inFunction = true;
+            localVariables.clear();
+            declaredGlobal.clear();
+            declaredLocal.clear();
+            stackOffset = 0;  // FrameLayout places the slots below the saved registers
+            maxStackOffset = stackOffset;
+            stackDepth = 0;
+            currentReturnLabel = labelName + "_return";
+            currentReturnKind = "";
+            currentFunction = func;
+            currentBodyLabel = labelName + "_body";
+            currentParamSlots.clear();
+            accumulatorSlot = 0;
+            indexErrorLabel = labelName + "_index_error";
+            indexErrorUsed = false;
+            availableValues.clear();
+            repeatedValues.clear();
+            stringBuilders.clear();
+            textVariables.clear();
+            if (!func->isSingleExpression) repeatedValues = findRepeatedValues(func->body);
+            functionCallStack.push_back(functionScopeNames[func]);
+            
+            // Set up parameters - move from calling convention registers to stack
+            std::vector<ArgumentLocation> locations = classifyParameters(*func);
+            
+            // The frame size is only known once the body has been generated, so the
+            // parameter moves are buffered and emitted after the prologue
+            std::ostringstream paramAsm;
+            paramAsm << "    # Setting up function parameters for " << funcName << "\n";
+            paramAsm << profileCount(func, Profile::Entries);
+            for (size_t i = 0; i < func->parameters.size(); i++) {
+                const auto& param = func->parameters[i];
                 
-                inFunction = true;
-                localVariables.clear();
-                stackOffset = 0;
+                // Allocate stack slot for parameter
+                allocateStackSlot();
+                VariableInfo paramInfo;
+                paramInfo.stackOffset = stackOffset;
+                // Try to infer parameter type from calling context, default to string for flexibility
+                paramInfo.type = parameterType(param);
+                paramInfo.isGlobal = false;
+                paramInfo.isConstant = false;
                 
-                // Set up parameters - move from calling convention registers to stack
-                const std::string callingConventionRegs[] = {"%rdi", "%rsi", "%rdx", "%rcx", "%r8", "%r9"};
+                // Register parameter in local variables
+                localVariables[param.name] = paramInfo;
+                currentParamSlots.push_back(stackOffset);
                 
-                funcsAsm << "    # Setting up function parameters for " << funcName << "\n";
-                for (size_t i = 0; i < func->parameters.size() && i < 6; i++) {
-                    const auto& param = func->parameters[i];
-                    
-                    // Allocate stack slot for parameter
-                    stackOffset += 8;
-                    VariableInfo paramInfo;
-                    paramInfo.stackOffset = stackOffset;
-                    // Try to infer parameter type from calling context, default to string for flexibility
-                    paramInfo.type = (param.type.toString() != "unknown") ? param.type.toString() : "string";
-                    paramInfo.isGlobal = false;
-                    paramInfo.isConstant = false;
-                    
-                    // Register parameter in local variables
-                    localVariables[param.name] = paramInfo;
-                    
-                    // Move parameter from register to stack
-                    funcsAsm << "    mov " << callingConventionRegs[i] << ", -" << stackOffset 
+                const ArgumentLocation& location = locations[i];
+                if (!location.reg.empty()) {
+                    paramAsm << "    " << (location.isFloat ? "movsd " : "mov ") << location.reg << ", -" << stackOffset 
                              << "(%rbp)  # Parameter " << param.name << " (type: " << paramInfo.type << ")\n";
-                }
-                
-                // Redirect assembly output to funcsAsm for function body generation
-                std::string currentAssembly = assembly.str();
-                assembly.str("");
-                assembly.clear();
-                
-                // Generate function body
-                if (func->isSingleExpression) {
-                    func->expression->accept(*this);
                 } else {
-                    for (auto& stmt : func->body) {
-                        stmt->accept(*this);
-                    }
+                    // Remaining parameters were pushed by the caller, above the return address
+                    paramAsm << "    mov " << (16 + 8 * location.stackIndex) << "(%rbp), %rax  # Stack parameter " << param.name << "\n";
+                    paramAsm << "    mov %rax, -" << stackOffset 
+                             << "(%rbp)  # Parameter " << param.name << " (type: " << paramInfo.type << ")\n";
+                }
+            }
+            
+            if (!func->isSingleExpression && analyzeAccumulatorRecursion(*func)) {
+                allocateStackSlot();
+                accumulatorSlot = stackOffset;
+                paramAsm << "    movq $" << (accumulatorOp == BinaryOp::MUL ? 1 : 0) << ", -" << accumulatorSlot
+                         << "(%rbp)  # Accumulator for recursive calls\n";
+            }
+            // Self tail calls jump here after storing the new parameter values
+            paramAsm << currentBodyLabel << ":\n";
+            
+            // Redirect assembly output for function body generation
+            std::string currentAssembly = assembly.str();
+            assembly.str("");
+            assembly.clear();
+            
+            // Generate function body
+            if (func->isSingleExpression) {
+                emitReturnValue(func->expression.get());
+            } else {
+                generateStatements(func->body);
+            }
+            
+            // Prologue: FrameLayout saves the callee-saved registers the final body
+            // uses and reserves its slots; leaf bodies that never move %rsp run
+            // without a frame
+            std::ostringstream functionText;
+            functionText << "\n" << labelName << ":\n";
+            functionText << FrameLayout::enter(maxStackOffset);
+            functionText << paramAsm.str();
+            
+            // Move generated body code after the prologue and restore assembly
+            functionText << assembly.str();
+            assembly.str("");
+            assembly.clear();
+            assembly << currentAssembly;
+            
+            // Function epilogue - every return statement jumps here with the value in %rax
+            // (and in %xmm0 as well for float results)
+            flushColdBlocks(functionText);
+            functionText << currentReturnLabel << ":\n";
+            emitFrameTeardown(functionText);
+            functionText << "    ret\n";
+            emitIndexErrorStub(functionText);
+            functionAsm[func] = functionText.str();
+            generatedFunctions.push_back(func);
+            
+            if (!currentReturnKind.empty()) {
+                functionReturnTypes[func] = currentReturnKind;
+            }
+            
+            // Restore previous state
+            functionCallStack.pop_back();
+            inFunction = wasInFunction;
+            localVariables = savedLocalVars;
+            declaredGlobal = savedDeclaredGlobal;
+            declaredLocal = savedDeclaredLocal;
+            stackOffset = savedStackOffset;
+            maxStackOffset = savedMaxStackOffset;
+            stackDepth = savedStackDepth;
+            currentReturnLabel = savedReturnLabel;
+            currentReturnKind = savedReturnKind;
+            currentFunction = savedFunction;
+            currentBodyLabel = savedBodyLabel;
+            currentParamSlots = savedParamSlots;
+            accumulatorSlot = savedAccumulatorSlot;
+            accumulatorOp = savedAccumulatorOp;
+            indexErrorLabel = savedIndexErrorLabel;
+            indexErrorUsed = savedIndexErrorUsed;
+            availableValues = savedAvailableValues;
+            repeatedValues = savedRepeatedValues;
+            stringBuilders = savedStringBuilders;
+            textVariables = savedTextVariables;
+        }
+    }
+    
+    // A call to the function being generated, made from its own body rather than
+    // from an inlined copy of some other function
+    bool isSelfCall(Expression* expr) {
+        auto call = dynamic_cast<FunctionCall*>(expr);
+        return call && currentFunction && inlineDepth == 0 && !isBuiltinFunction(call->name) &&
+               findFunction(call->name) == currentFunction;
+    }
+    
+    // Splits `f(...) op e` or `e op f(...)` (op is + or *) into the self call and e
+    bool matchAccumulatorReturn(Expression* value, FunctionCall*& tail, Expression*& operand, BinaryOp& op) {
+        auto binary = dynamic_cast<BinaryExpression*>(value);
+        if (!binary || (binary->op != BinaryOp::ADD && binary->op != BinaryOp::MUL)) {
+            return false;
+        }
+        if (isSelfCall(binary->left.get())) {
+            tail = static_cast<FunctionCall*>(binary->left.get());
+            operand = binary->right.get();
+        } else if (isSelfCall(binary->right.get())) {
+            tail = static_cast<FunctionCall*>(binary->right.get());
+            operand = binary->left.get();
+        } else {
+            return false;
+        }
+        op = binary->op;
+        return true;
+    }
+    
+    // Integer arithmetic over literals, int variables, untyped parameters used
+    // only as integers (integerParameters) and self calls
+    bool isIntegerOperand(Expression* expr, bool& hasSelfCall) {
+        if (dynamic_cast<IntLiteral*>(expr)) {
+            return true;
+        }
+        if (auto id = dynamic_cast<Identifier*>(expr)) {
+            auto varInfo = lookupVariable(id->name);
+            return varInfo && (varInfo->type == "int" || integerParameters.count(id->name));
+        }
+        if (auto binary = dynamic_cast<BinaryExpression*>(expr)) {
+            if (binary->op != BinaryOp::ADD && binary->op != BinaryOp::SUB && binary->op != BinaryOp::MUL) {
+                return false;
+            }
+            return isIntegerOperand(binary->left.get(), hasSelfCall) &&
+                   isIntegerOperand(binary->right.get(), hasSelfCall);
+        }
+        if (auto unary = dynamic_cast<UnaryExpression*>(expr)) {
+            return unary->op != UnaryOp::NOT && isIntegerOperand(unary->operand.get(), hasSelfCall);
+        }
+        if (isSelfCall(expr)) {
+            hasSelfCall = true;
+            return true;
+        }
+        return false;
+    }
+    
+    // Decide whether every return of the current function can be rewritten so that
+    // self calls become jumps: `return f(a) op e` adds e to the accumulator and loops,
+    // any other return yields `accumulator op value`. The function must return ints,
+    // and self calls that stay real calls are only allowed when the body has no side
+    // effects, since e is now evaluated before the call it followed.
+    bool analyzeAccumulatorRecursion(FunctionDeclaration& func) {
+        RecursionScanner scanner([this](FunctionCall& call) { return isSelfCall(&call); });
+        for (auto& stmt : func.body) {
+            stmt->accept(scanner);
+        }
+        if (scanner.selfCalls.empty() || scanner.selfCallsOutsideReturns > 0) {
+            return false;
+        }
+        
+        std::unordered_set<std::string> untyped;
+        for (const auto& param : func.parameters) {
+            if (param.type.toString() == "unknown") untyped.insert(param.name);
+        }
+        IntegerParameterScanner integers(untyped, [this](FunctionCall& call) { return isSelfCall(&call); });
+        for (auto& stmt : func.body) {
+            stmt->accept(integers);
+        }
+        integerParameters = integers.integers();
+        
+        bool opChosen = false;
+        bool needsPurity = false;
+        for (ReturnStatement* ret : scanner.returns) {
+            if (!ret->value) {
+                return false;
+            }
+            if (isSelfCall(ret->value.get())) {
+                continue;  // Plain tail call, needs no accumulator
+            }
+            FunctionCall* tail = nullptr;
+            Expression* operand = nullptr;
+            BinaryOp op;
+            bool hasSelfCall = false;
+            if (matchAccumulatorReturn(ret->value.get(), tail, operand, op)) {
+                if (opChosen && op != accumulatorOp) {
+                    return false;
+                }
+                accumulatorOp = op;
+                opChosen = true;
+                if (!isIntegerOperand(operand, hasSelfCall)) {
+                    return false;
                 }
-                
-                // Move generated body code to funcsAsm and restore assembly
-                funcsAsm << assembly.str();
-                assembly.str("");
-                assembly.clear();
-                assembly << currentAssembly;
-                
-                // Function epilogue - user functions should return to caller
-                funcsAsm << "    add $64, %rsp  # Restore stack space\n";
-                funcsAsm << "    pop %rbp\n";
-                funcsAsm << "    ret\n";
-                
-                // Restore previous state
-                inFunction = wasInFunction;
-                localVariables = savedLocalVars;
-                stackOffset = savedStackOffset;
+            } else if (!isIntegerOperand(ret->value.get(), hasSelfCall)) {
+                return false;
             }
+            needsPurity = needsPurity || hasSelfCall;
         }
+        return opChosen && !(needsPurity && scanner.hasSideEffects);
     }
     
-    void visit(FunctionDeclaration& node) override {
-        // Functions are only executed when called, not when defined
-        assembly << "    # Function '" << node.name << "' defined but not executed\n";
-        
-        // Function definitions are collected in the collectFunctions phase
-        // Assembly generation happens in generateFunctionAssembly phase
-        // This ensures proper scoping and calling convention setup
+    // Evaluate a function's result: %rax, and %xmm0 as well for floats as the ABI
+    // requires. Records the kind of value returned.
+    void emitReturnValue(Expression* value) {
+        std::string kind = exprKindToType(inferExprKind(value));
+        if (kind == "float") {
+            emitFloat(value);
+            assembly << "    movq %xmm0, %rax\n";
+        } else {
+            value->accept(*this);
+        }
+        if (inFunction && !kind.empty()) currentReturnKind = kind;
     }
     
-    void executeFunctionCall(const std::string& functionName, const std::vector<std::unique_ptr<Expression>>& arguments) {
-        assembly << "    # Executing function call: " << functionName << "\n";
-        
-        // Find the function in the current scope
-        FunctionDeclaration* func = findFunction(functionName);
-        if (!func) {
-            throw std::runtime_error("Error: Undefined function '" + functionName + "' in current scope");
+    // Store new parameter values and jump back to the top of the current function
+    void emitSelfTailCall(FunctionCall& call) {
+        checkCallArguments(call, currentFunction);
+        assembly << "    # Tail call to self: " << call.name << "\n";
+        assembly << profileCount(&call);
+        assembly << profileCount(currentFunction, Profile::Entries);
+        for (size_t i = 0; i < call.arguments.size(); i++) {
+            pushArgument(call.arguments[i].get(), parameterType(currentFunction->parameters[i]) == "float", i);
         }
-        
-        // Save current function state
-        bool wasInFunction = inFunction;
-        auto savedLocalVars = localVariables;
-        auto savedDeclaredGlobal = declaredGlobal;
-        auto savedDeclaredLocal = declaredLocal;
-        int savedStackOffset = stackOffset;
-        
-        // Push function onto call stack for proper scoping
-        std::string currentScope = "";
-        if (!functionCallStack.empty()) {
-            currentScope = functionCallStack.back();
+        for (size_t i = call.arguments.size(); i-- > 0;) {
+            popTemp("%rax");
+            assembly << "    mov %rax, -" << currentParamSlots[i] << "(%rbp)  # Parameter "
+                     << currentFunction->parameters[i].name << "\n";
+        }
+        assembly << "    jmp " << currentBodyLabel << "\n";
+    }
+    
+    // Tear down the current frame and jump to another function, which returns
+    // straight to our caller. Only register arguments fit in the frame we leave behind.
+    bool tryEmitSiblingTailCall(Expression* value) {
+        auto call = dynamic_cast<FunctionCall*>(value);
+        if (!call || isBuiltinFunction(call->name) || inlineCosts.shouldInline(call)) {
+            return false;
+        }
+        FunctionDeclaration* callee = findFunction(call->name);
+        if (!callee) {
+            return false;
+        }
+        checkCallArguments(*call, callee);
+        std::vector<ArgumentLocation> locations = classifyParameters(*callee);
+        for (const auto& location : locations) {
+            if (location.reg.empty()) return false;
         }
-        std::string newScope = currentScope.empty() ? functionName : currentScope + "::" + functionName;
-        functionCallStack.push_back(newScope);
-        
-        // Enter new function scope
-        inFunction = true;
-        localVariables.clear(); // Clear local variables for new function scope
-        declaredGlobal.clear(); // Clear global declarations for new function
-        declaredLocal.clear(); // Clear local declarations for new function
-        
-        // Set up function prologue: register parameters and move from calling convention registers
-        assembly << "    # Function prologue: setting up parameters\n";
-        
-        // Register each parameter as a local variable with proper stack slot
-        const std::string callingConventionRegs[] = {"%rdi", "%rsi", "%rdx", "%rcx", "%r8", "%r9"};
         
-        for (size_t i = 0; i < func->parameters.size(); i++) {
-            const auto& param = func->parameters[i];
-            
-            // Allocate stack slot for parameter
-            stackOffset += 8;
-            VariableInfo paramInfo;
-            paramInfo.stackOffset = stackOffset;
-            paramInfo.type = param.type.toString(); // Convert Type to string
-            paramInfo.isGlobal = false;
-            paramInfo.isConstant = false;
-            
-            // Register parameter in local variables
-            localVariables[param.name] = paramInfo;
-            
-            // Move parameter value from calling convention register to stack slot
-            if (i < 6) {
-                // First 6 parameters are passed in registers
-                assembly << "    mov " << callingConventionRegs[i] << ", -" << paramInfo.stackOffset << "(%rbp)  # param " << param.name << " from " << callingConventionRegs[i] << "\n";
+        assembly << "    # Tail call: " << call->name << "\n";
+        assembly << profileCount(call);
+        for (size_t i = 0; i < call->arguments.size(); i++) {
+            pushArgument(call->arguments[i].get(), locations[i].isFloat, i);
+        }
+        for (size_t i = call->arguments.size(); i-- > 0;) {
+            if (locations[i].isFloat) {
+                popFloatTemp(locations[i].reg);
             } else {
-                // Additional parameters are passed on stack (simplified - would need proper stack offset calculation)
-                assembly << "    # Note: Parameter " << param.name << " beyond register capacity - would be on stack\n";
-                assembly << "    mov $0, -" << paramInfo.stackOffset << "(%rbp)  # placeholder for stack parameter " << param.name << "\n";
+                popTemp(locations[i].reg);
             }
-            
-            assembly << "    # Parameter " << param.name << " (type: " << paramInfo.type << ") at stack offset -" << paramInfo.stackOffset << "\n";
         }
+        emitFrameTeardown(assembly);
+        assembly << "    jmp " << functionLabels[callee] << "\n";
+        functionCallees[currentFunction].insert(callee);
         
-        // Execute function body
-        if (func->isSingleExpression) {
-            func->expression->accept(*this);
-        } else {
-            for (auto& stmt : func->body) {
-                stmt->accept(*this);
-            }
-        }
+        std::string kind = exprKindToType(inferExprKind(call));
+        if (!kind.empty()) currentReturnKind = kind;
+        return true;
+    }
+    
+    void visit(FunctionDeclaration& node) override {
+        // Functions are only executed when called, not when defined
+        assembly << "    # Function '" << node.name << "' defined but not executed\n";
         
-        // Exit function scope - restore previous state and pop call stack
-        functionCallStack.pop_back();
-        inFunction = wasInFunction;
-        localVariables = savedLocalVars; // Restore previous local scope
-        declaredGlobal = savedDeclaredGlobal;
-        declaredLocal = savedDeclaredLocal;
-        stackOffset = savedStackOffset; // Restore stack offset
+        // Function definitions are collected in the collectFunctions phase
+        // Assembly generation happens in generateFunctionAssembly phase
+        // This ensures proper scoping and calling convention setup
     }
     
     FunctionDeclaration* findFunction(const std::string& name) {
-        // Implement Python-style function scoping: look in current scope, then parent scopes, then global
-        
         // Start from current function context (if any)
         std::string currentScope = "";
         if (!functionCallStack.empty()) {
             currentScope = functionCallStack.back();
         }
+        return findFunctionInScope(name, currentScope);
+    }
+    
+    FunctionDeclaration* findFunctionInScope(const std::string& name, const std::string& currentScope) {
+        // Implement Python-style function scoping: look in current scope, then parent scopes, then global
         
         // Search in current scope hierarchy (from innermost to outermost)
         std::string searchScope = currentScope;
@@ -539,6 +1785,8 @@ public:
                 varType = "int";
             } else if (auto strLit = dynamic_cast<StringLiteral*>(node.initializer.get())) {
                 varType = "string";
+            } else if (dynamic_cast<InterpolatedString*>(node.initializer.get())) {
+                varType = "string";
             } else if (auto boolLit = dynamic_cast<BoolLiteral*>(node.initializer.get())) {
                 varType = "bool";
             } else if (auto floatLit = dynamic_cast<FloatLiteral*>(node.initializer.get())) {
@@ -563,7 +1811,9 @@ public:
                     case BinaryOp::FLOOR_DIV:
                     case BinaryOp::POWER:
                         // Check if either operand is a float
-                        if (isFloatExpression(binExpr->left.get()) || isFloatExpression(binExpr->right.get())) {
+                        if (inferExprKind(binExpr) == ExprKind::STRING) {
+                            varType = "string";
+                        } else if (isFloatExpression(binExpr->left.get()) || isFloatExpression(binExpr->right.get())) {
                             varType = "float";
                         } else {
                             varType = "int";
@@ -592,10 +1842,18 @@ public:
                 } else if (funcCall->name == "dtype") {
                     varType = "string";  // dtype() returns a string representation
                 } else {
-                    // For user-defined functions, we don't know the return type yet
-                    // Default to unknown and let runtime handle it
-                    varType = "string";  // Most user functions likely return strings or can be treated as such
+                    // For user-defined functions, use the return type observed when the
+                    // function body was generated, if any
+                    std::string returnType = exprKindToType(inferExprKind(funcCall));
+                    if (!returnType.empty()) {
+                        varType = returnType;
+                    } else {
+                        varType = "string";  // Most user functions likely return strings or can be treated as such
+                    }
                 }
+            } else {
+                std::string kind = exprKindToType(inferExprKind(node.initializer.get()));
+                if (!kind.empty()) varType = kind;
             }
             
             // Check if variable already exists - if so, treat as reassignment
@@ -609,14 +1867,14 @@ public:
                 if (existingVar->isConstant) {
                     throw std::runtime_error("Error: You are trying to change the value of a constant variable '" + node.name + "'");
                 }
-                // Update type if needed, but keep existing slot and scope
-                existingVar->type = varType;
+                // The type changes once the new value is stored: the initializer
+                // still sees the old one
             } else {
                 // Variable doesn't exist - create new variable
                 // Python-style scoping rules - PRE-DECLARE variable before evaluating initializer
                 if (declaredGlobal.count(node.name) || (!inFunction)) {
                     // Explicitly declared global OR not in function - use global scope
-                    stackOffset += 8;
+                    allocateStackSlot();
                     VariableInfo varInfo;
                     varInfo.stackOffset = stackOffset;
                     varInfo.type = varType;
@@ -629,7 +1887,7 @@ public:
                     }
                 } else {
                     // In function and not declared global - create local variable
-                    stackOffset += 8;
+                    allocateStackSlot();
                     VariableInfo varInfo;
                     varInfo.stackOffset = stackOffset;
                     varInfo.type = varType;
@@ -643,14 +1901,26 @@ public:
                 }
             }
             
-            // Now evaluate initializer - variable is already declared
-            node.initializer->accept(*this);
+            // Now evaluate initializer - variable is already declared. Floats are
+            // computed and stored from %xmm0.
+            bool isText = varType == "string" && isCertainString(node.initializer.get());
+            bool isFloat = varType == "float";
+            if (isFloat) {
+                emitFloat(node.initializer.get());
+            } else if (BinaryExpression* append = stringBuilderAppend(node)) {
+                emitStringConcat(*append, "orion_sb_append");
+            } else {
+                node.initializer->accept(*this);
+            }
             
             // Store the result in the pre-allocated variable slot using recorded offset
             VariableInfo* varInfo = lookupVariable(node.name);
             if (varInfo != nullptr) {
-                assembly << "    mov %rax, -" << varInfo->stackOffset << "(%rbp)  # store " << (varInfo->isGlobal ? "global" : "local") << " " << node.name << "\n";
+                varInfo->type = varType;
+                assembly << "    " << (isFloat ? "movsd %xmm0" : "mov %rax") << ", -" << varInfo->stackOffset << "(%rbp)  # store " << (varInfo->isGlobal ? "global" : "local") << " " << node.name << "\n";
             }
+            forgetValuesOf(node.name);
+            noteStore(node.name, isText);
         }
     }
     
@@ -683,6 +1953,12 @@ public:
             }
             assembly << "    # str() type conversion function call\n";
             
+            if (isFloatExpression(node.arguments[0].get())) {
+                emitFloat(node.arguments[0].get());
+                assembly << "    call __orion_float_to_string\n";
+                return;
+            }
+            
             // Evaluate the argument
             node.arguments[0]->accept(*this);
             
@@ -788,46 +2064,8 @@ public:
                 throw std::runtime_error("flt() function requires exactly 1 argument");
             }
             assembly << "    # flt() type conversion function call\n";
-            
-            // Evaluate the argument
-            node.arguments[0]->accept(*this);
-            
-            // Determine the type of the argument and call appropriate runtime helper
-            auto argExpr = node.arguments[0].get();
-            if (auto intLit = dynamic_cast<IntLiteral*>(argExpr)) {
-                assembly << "    mov %rax, %rdi  # int argument\n";
-                assembly << "    call __orion_int_to_float\n";
-            } else if (auto floatLit = dynamic_cast<FloatLiteral*>(argExpr)) {
-                // Float to float is identity - result already in %rax
-                assembly << "    # Float to float conversion (identity)\n";
-            } else if (auto boolLit = dynamic_cast<BoolLiteral*>(argExpr)) {
-                assembly << "    mov %rax, %rdi  # bool argument\n";
-                assembly << "    call __orion_bool_to_float\n";
-            } else if (auto strLit = dynamic_cast<StringLiteral*>(argExpr)) {
-                assembly << "    mov %rax, %rdi  # string argument\n";
-                assembly << "    call __orion_string_to_float\n";
-            } else if (auto id = dynamic_cast<Identifier*>(argExpr)) {
-                // Variable - determine type from variable info
-                auto varInfo = lookupVariable(id->name);
-                if (varInfo) {
-                    if (varInfo->type == "int") {
-                        assembly << "    mov %rax, %rdi  # int variable\n";
-                        assembly << "    call __orion_int_to_float\n";
-                    } else if (varInfo->type == "float") {
-                        assembly << "    # Float variable to float conversion (identity)\n";
-                    } else if (varInfo->type == "bool") {
-                        assembly << "    mov %rax, %rdi  # bool variable\n";
-                        assembly << "    call __orion_bool_to_float\n";
-                    } else if (varInfo->type == "string") {
-                        assembly << "    mov %rax, %rdi  # string variable\n";
-                        assembly << "    call __orion_string_to_float\n";
-                    }
-                }
-            } else {
-                // For complex expressions, default to int to float conversion
-                assembly << "    mov %rax, %rdi  # complex expression argument\n";
-                assembly << "    call __orion_int_to_float  # Default to int to float\n";
-            }
+            emitFltCall(node);
+            assembly << "    movq %xmm0, %rax  # Float result as raw bits\n";
             return;
         }
         
@@ -836,6 +2074,7 @@ public:
             if (node.arguments.size() != 1) {
                 throw std::runtime_error("len() function requires exactly 1 argument");
             }
+            if (emitReusableValue(node)) return;
             assembly << "    # len() function call\n";
             
             // Check if the argument is a range() function call
@@ -850,6 +2089,14 @@ public:
                 }
             }
             
+            if (isLengthOfText(node)) {
+                // Strings carry their length in a header
+                node.arguments[0]->accept(*this);
+                assembly << "    mov %rax, %rdi\n";
+                emitAlignedCall("orion_str_len");
+                return;
+            }
+            
             // Default to list behavior for other cases
             node.arguments[0]->accept(*this);  // Evaluate list argument
             assembly << "    mov %rax, %rdi  # List pointer as argument\n";
@@ -867,14 +2114,15 @@ public:
             // Evaluate list argument
             node.arguments[0]->accept(*this);
             assembly << "    mov %rax, %rdi  # List pointer as first argument\n";
-            assembly << "    push %rdi  # Save list pointer\n";
+            pushTemp("%rdi", "Save list pointer");
             
             // Evaluate element argument
             node.arguments[1]->accept(*this);
             assembly << "    mov %rax, %rsi  # Element value as second argument\n";
-            assembly << "    pop %rdi  # Restore list pointer\n";
+            popTemp("%rdi", "Restore list pointer");
             
             assembly << "    call list_append  # Append element to list\n";
+            forgetLengthValues();
             // append returns void, so no return value
             return;
         }
@@ -887,6 +2135,7 @@ public:
             node.arguments[0]->accept(*this);  // Evaluate list argument
             assembly << "    mov %rax, %rdi  # List pointer as argument\n";
             assembly << "    call list_pop  # Pop last element\n";
+            forgetLengthValues();
             // Result (popped element) in %rax
             return;
         }
@@ -908,27 +2157,27 @@ public:
                 // range(start, stop) - step=1
                 node.arguments[0]->accept(*this);  // Evaluate start argument
                 assembly << "    mov %rax, %rdi  # Start value as first argument\n";
-                assembly << "    push %rdi  # Save start value\n";
+                pushTemp("%rdi", "Save start value");
                 
                 node.arguments[1]->accept(*this);  // Evaluate stop argument
                 assembly << "    mov %rax, %rsi  # Stop value as second argument\n";
-                assembly << "    pop %rdi  # Restore start value\n";
+                popTemp("%rdi", "Restore start value");
                 
                 assembly << "    call range_new_start_stop  # Create range with start and stop\n";
             } else {
                 // range(start, stop, step)
                 node.arguments[0]->accept(*this);  // Evaluate start argument
                 assembly << "    mov %rax, %rdi  # Start value as first argument\n";
-                assembly << "    push %rdi  # Save start value\n";
+                pushTemp("%rdi", "Save start value");
                 
                 node.arguments[1]->accept(*this);  // Evaluate stop argument
                 assembly << "    mov %rax, %rsi  # Stop value as second argument\n";
-                assembly << "    push %rsi  # Save stop value\n";
+                pushTemp("%rsi", "Save stop value");
                 
                 node.arguments[2]->accept(*this);  // Evaluate step argument
                 assembly << "    mov %rax, %rdx  # Step value as third argument\n";
-                assembly << "    pop %rsi  # Restore stop value\n";
-                assembly << "    pop %rdi  # Restore start value\n";
+                popTemp("%rsi", "Restore stop value");
+                popTemp("%rdi", "Restore start value");
                 
                 assembly << "    call range_new  # Create range with start, stop, and step\n";
             }
@@ -947,31 +2196,32 @@ public:
                     if (funcCall->name == "str") {
                         assembly << "    # Call out() with str() result\n";
                         funcCall->accept(*this);  // This calls str() and puts result in %rax
-                        assembly << "    mov %rax, %rsi  # String pointer as argument\n";
-                        assembly << "    mov $format_str, %rdi  # Use string format\n";
-                        assembly << "    xor %rax, %rax\n";
-                        assembly << "    call printf\n";
+                        assembly << "    mov %rax, %rdi  # String pointer as argument\n";
+                        emitAlignedCall("orion_out_str");
                         return;
                     } else if (funcCall->name == "int") {
                         assembly << "    # Call out() with int() result\n";
                         funcCall->accept(*this);  // This calls int() and puts result in %rax
-                        assembly << "    mov %rax, %rsi  # Integer value as argument\n";
-                        assembly << "    mov $format_int, %rdi  # Use integer format\n";
-                        assembly << "    xor %rax, %rax\n";
-                        assembly << "    call printf\n";
+                        assembly << "    mov %rax, %rdi  # Integer value as argument\n";
+                        emitAlignedCall("orion_out_i64");
                         return;
                     } else if (funcCall->name == "flt") {
                         assembly << "    # Call out() with flt() result\n";
-                        funcCall->accept(*this);  // This calls flt() and puts result in %rax
-                        assembly << "    movq %rax, %xmm0  # Float value to XMM register\n";
-                        assembly << "    mov $format_float, %rdi  # Use float format\n";
-                        assembly << "    mov $1, %rax  # Number of vector registers used\n";
-                        assembly << "    call printf\n";
+                        if (funcCall->arguments.size() != 1) {
+                            throw std::runtime_error("flt() function requires exactly 1 argument");
+                        }
+                        emitFltCall(*funcCall);  // Result in %xmm0
+                        emitAlignedCall("orion_out_f64");
                         return;
                     } else if (funcCall->name == "dtype" && !funcCall->arguments.empty()) {
                         // Handle dtype() call inside out()
                         auto dtypeArg = funcCall->arguments[0].get();
-                        if (auto id = dynamic_cast<Identifier*>(dtypeArg)) {
+                        std::string literal = literalType(dtypeArg);
+                        if (!literal.empty()) {
+                            assembly << "    # Call out(dtype(" << literal << " literal))\n";
+                            assembly << "    mov $dtype_" << literal << ", %rdi\n";
+                            emitAlignedCall("orion_out_str");
+                        } else if (auto id = dynamic_cast<Identifier*>(dtypeArg)) {
                             auto varIt = lookupVariable(id->name);
                             if (varIt != nullptr) {
                                 assembly << "    # Call out(dtype(" << id->name << "))\n";
@@ -989,10 +2239,8 @@ public:
                                 } else {
                                     dtypeLabel = "dtype_unknown";
                                 }
-                                assembly << "    mov $" << dtypeLabel << ", %rsi\n";
-                                assembly << "    mov $format_str, %rdi\n";
-                                assembly << "    xor %rax, %rax\n";
-                                assembly << "    call printf\n";
+                                assembly << "    mov $" << dtypeLabel << ", %rdi\n";
+                                emitAlignedCall("orion_out_str");
                             } else {
                                 throw std::runtime_error("Line " + std::to_string(id->line) + ": Error: Undefined variable '" + id->name + "'");
                             }
@@ -1004,58 +2252,45 @@ public:
                 // Check the type of argument to determine format
                 if (auto intLit = dynamic_cast<IntLiteral*>(arg.get())) {
                     assembly << "    # Call out() with integer\n";
-                    assembly << "    mov $" << intLit->value << ", %rsi\n";
-                    assembly << "    mov $format_int, %rdi\n";
-                    assembly << "    xor %rax, %rax\n";
-                    assembly << "    call printf\n";
+                    assembly << "    mov $" << intLit->value << ", %rdi\n";
+                    emitAlignedCall("orion_out_i64");
                 } else if (auto strLit = dynamic_cast<StringLiteral*>(arg.get())) {
                     int index = addStringLiteral(strLit->value);
                     assembly << "    # Call out() with string\n";
-                    assembly << "    mov $str_" << index << ", %rsi\n";
-                    assembly << "    mov $format_str, %rdi\n";
-                    assembly << "    xor %rax, %rax\n";
-                    assembly << "    call printf\n";
+                    assembly << "    mov $str_" << index << ", %rdi\n";
+                    emitAlignedCall("orion_out_str");
                 } else if (auto id = dynamic_cast<Identifier*>(arg.get())) {
                     // Variable reference - use correct format based on type
                     auto it = lookupVariable(id->name);
                     if (it != nullptr) {
                         assembly << "    # Call out() with variable: " << id->name << " (type: " << it->type << ")\n";
-                        assembly << "    mov -" << it->stackOffset << "(%rbp), %rsi\n";
-                        
-                        if (it->type == "int") {
-                            assembly << "    mov $format_int, %rdi\n";
-                            assembly << "    xor %rax, %rax\n";
-                        } else if (it->type == "bool") {
-                            assembly << "    mov $format_str, %rdi\n";
-                            assembly << "    xor %rax, %rax\n";
-                        } else if (it->type == "float") {
-                            assembly << "    movq -" << it->stackOffset << "(%rbp), %xmm0\n";  // Load float into XMM register  
-                            assembly << "    mov $format_float, %rdi\n";
-                            assembly << "    mov $1, %rax\n";  // Number of vector registers used
+                        if (it->type == "float") {
+                            assembly << "    movq -" << it->stackOffset << "(%rbp), %xmm0\n";  // Load float into XMM register
+                            emitAlignedCall("orion_out_f64");
                         } else {
-                            assembly << "    mov $format_str, %rdi\n";
-                            assembly << "    xor %rax, %rax\n";
+                            assembly << "    mov -" << it->stackOffset << "(%rbp), %rdi\n";
+                            if (it->type == "int") {
+                                emitAlignedCall("orion_out_i64");
+                            } else if (it->type == "bool") {
+                                emitAlignedCall("orion_out_bool");
+                            } else {
+                                emitAlignedCall("orion_out_str");
+                            }
                         }
-                        
-                        assembly << "    call printf\n";
                     } else {
                         throw std::runtime_error("Error: Undefined variable '" + id->name + "'");
                     }
                 } else if (auto boolLit = dynamic_cast<BoolLiteral*>(arg.get())) {
                     // Boolean literal - output as string
                     assembly << "    # Call out() with boolean literal\n";
-                    assembly << "    mov $" << (boolLit->value ? "str_true" : "str_false") << ", %rsi\n";
-                    assembly << "    mov $format_str, %rdi\n";
-                    assembly << "    xor %rax, %rax\n";
-                    assembly << "    call printf\n";
+                    assembly << "    mov $" << (boolLit->value ? 1 : 0) << ", %rdi  # Booleans print as text\n";
+                    emitAlignedCall("orion_out_bool");
                 } else if (auto interpolated = dynamic_cast<InterpolatedString*>(arg.get())) {
                     // Handle interpolated string - evaluate it and treat result as string
                     assembly << "    # Call out() with interpolated string\n";
                     arg->accept(*this);  // This calls our InterpolatedString visitor
-                    assembly << "    mov %rax, %rsi  # String pointer from interpolation result\n";
-                    assembly << "    mov $format_str, %rdi  # Use string format\n";
-                    assembly << "    xor %rax, %rax\n";
-                    assembly << "    call printf\n";
+                    assembly << "    mov %rax, %rdi  # String pointer from interpolation result\n";
+                    emitAlignedCall("orion_out_str");
                 } else {
                     // Generic expression (like arithmetic operations or comparisons)
                     // Check if the expression result is a float
@@ -1069,36 +2304,39 @@ public:
                             binExpr->op == BinaryOp::GT || binExpr->op == BinaryOp::GE ||
                             binExpr->op == BinaryOp::AND || binExpr->op == BinaryOp::OR) {
                             isComparisonResult = true;
-                        } else {
-                            isFloatResult = isFloatExpression(binExpr->left.get()) || isFloatExpression(binExpr->right.get());
                         }
                     } else if (auto unaryExpr = dynamic_cast<UnaryExpression*>(arg.get())) {
                         // Check if it's a NOT operation (returns string)
                         if (unaryExpr->op == UnaryOp::NOT) {
                             isComparisonResult = true;
                         }
-                    } else if (auto floatLit = dynamic_cast<FloatLiteral*>(arg.get())) {
-                        isFloatResult = true;
                     }
+                    isFloatResult = !isComparisonResult && isFloatExpression(arg.get());
+                    auto concat = dynamic_cast<BinaryExpression*>(arg.get());
+                    bool isStringResult = concat && isStringConcat(concat);
                     
-                    arg->accept(*this);
+                    // Float values are printed straight from %xmm0
+                    if (isFloatResult) {
+                        emitFloat(arg.get());
+                    } else {
+                        arg->accept(*this);
+                    }
                     assembly << "    # Call out() with expression result\n";
                     
                     if (isComparisonResult) {
-                        // Comparison results are string addresses (str_true/str_false)
-                        assembly << "    mov %rax, %rsi\n";
-                        assembly << "    mov $format_str, %rdi\n";  // Use string format for comparison results
-                        assembly << "    xor %rax, %rax\n";
+                        // Comparison results are 0/1 and print as text
+                        assembly << "    mov %rax, %rdi\n";
+                        emitAlignedCall("orion_out_bool");
                     } else if (isFloatResult) {
-                        assembly << "    movq %rax, %xmm0  # Load float result into XMM register\n";
-                        assembly << "    mov $format_float, %rdi\n";
-                        assembly << "    mov $1, %rax  # Number of vector registers used\n";
+                        emitAlignedCall("orion_out_f64");
+                    } else if (isStringResult) {
+                        // Concatenations print as text
+                        assembly << "    mov %rax, %rdi\n";
+                        emitAlignedCall("orion_out_str");
                     } else {
-                        assembly << "    mov %rax, %rsi\n";
-                        assembly << "    mov $format_int, %rdi\n";  // Use integer format for computed results
-                        assembly << "    xor %rax, %rax\n";
+                        assembly << "    mov %rax, %rdi\n";
+                        emitAlignedCall("orion_out_i64");
                     }
-                    assembly << "    call printf\n";
                 }
             }
         } else if (node.name == "input") {
@@ -1140,7 +2378,11 @@ public:
             // Handle standalone dtype() calls (though typically used inside out())
             if (!node.arguments.empty()) {
                 auto& arg = node.arguments[0];
-                if (auto id = dynamic_cast<Identifier*>(arg.get())) {
+                std::string literal = literalType(arg.get());
+                if (!literal.empty()) {
+                    assembly << "    # dtype(" << literal << " literal)\n";
+                    assembly << "    mov $dtype_" << (literal == "list" ? "unknown" : literal) << ", %rax\n";
+                } else if (auto id = dynamic_cast<Identifier*>(arg.get())) {
                     auto varIt = lookupVariable(id->name);
                     if (varIt != nullptr) {
                         assembly << "    # dtype(" << id->name << ") - type: " << varIt->type << "\n";
@@ -1165,25 +2407,234 @@ public:
                 }
             }
         } else {
-            // Handle user-defined function calls - generate proper assembly
+            // Handle user-defined function calls - System V AMD64 calling convention
+            FunctionDeclaration* func = findFunction(node.name);
+            if (!func) {
+                throw std::runtime_error("Error: Undefined function '" + node.name + "' in current scope");
+            }
+            checkCallArguments(node, func);
+            assembly << profileCount(&node);
+            
+            if (inlineDepth < kMaxInlineDepth && inlineCosts.shouldInline(&node)) {
+                generateInlineCall(node, func);
+                return;
+            }
+            
             assembly << "    # User-defined function call: " << node.name << "\n";
             
-            // Prepare arguments in calling convention registers
-            const std::string callingConventionRegs[] = {"%rdi", "%rsi", "%rdx", "%rcx", "%r8", "%r9"};
+            std::vector<ArgumentLocation> locations = classifyParameters(*func);
+            size_t argCount = node.arguments.size();
+            size_t stackArgs = 0;
+            for (const auto& location : locations) {
+                if (location.reg.empty()) stackArgs++;
+            }
             
-            for (size_t i = 0; i < node.arguments.size() && i < 6; i++) {
+            // Evaluate arguments left to right into stack temporaries so that evaluating
+            // a later argument (possibly another call) cannot clobber an earlier one
+            for (size_t i = 0; i < argCount; i++) {
                 assembly << "    # Preparing argument " << i << "\n";
-                node.arguments[i]->accept(*this);  // Result in %rax
-                assembly << "    mov %rax, " << callingConventionRegs[i] << "  # Arg " << i << " to " << callingConventionRegs[i] << "\n";
+                pushArgument(node.arguments[i].get(), locations[i].isFloat, i);
+            }
+            
+            // %rsp must be 16-byte aligned at the call instruction, after stack arguments are pushed
+            int padding = ((stackDepth + 8 * static_cast<int>(stackArgs)) % 16 != 0) ? 8 : 0;
+            if (padding) {
+                assembly << "    sub $8, %rsp  # Align stack for call\n";
             }
             
-            // Generate the function call with correct label name
-            std::string callLabel = (node.name == "main") ? "fn_main" : node.name;
-            assembly << "    call " << callLabel << "\n";
+            // Stack arguments are pushed last first, so the first lands just above the return address
+            size_t pushed = 0;
+            for (size_t i = argCount; i-- > 0;) {
+                if (!locations[i].reg.empty()) continue;
+                int offset = 8 * static_cast<int>(argCount - 1 - i) + padding + 8 * static_cast<int>(pushed);
+                assembly << "    pushq " << offset << "(%rsp)  # Stack arg " << i << "\n";
+                pushed++;
+            }
+            
+            // Register arguments: integers in %rdi..%r9, floats in %xmm0..%xmm7
+            for (size_t i = 0; i < argCount; i++) {
+                if (locations[i].reg.empty()) continue;
+                int offset = 8 * static_cast<int>(argCount - 1 - i) + padding + 8 * static_cast<int>(stackArgs);
+                assembly << "    " << (locations[i].isFloat ? "movsd " : "mov ") << offset << "(%rsp), " << locations[i].reg
+                         << "  # Arg " << i << " to " << locations[i].reg << "\n";
+            }
+            
+            assembly << "    call " << functionLabels[func] << "\n";
+            functionCallees[currentFunction].insert(func);
+            availableValues.clear();  // The callee may assign globals and resize lists
+            
+            // Release outgoing arguments, alignment padding and argument temporaries
+            int releaseBytes = 8 * static_cast<int>(stackArgs + argCount) + padding;
+            if (releaseBytes > 0) {
+                assembly << "    add $" << releaseBytes << ", %rsp  # Release call arguments\n";
+            }
+            stackDepth -= 8 * static_cast<int>(argCount);
+            
+            // Float results come back in %xmm0; keep the raw bits in %rax like other floats
+            auto retIt = functionReturnTypes.find(func);
+            if (retIt != functionReturnTypes.end() && retIt->second == "float") {
+                assembly << "    movq %xmm0, %rax  # Float return value\n";
+            }
+        }
+    }
+    
+    void checkCallArguments(FunctionCall& node, FunctionDeclaration* func) {
+        if (node.arguments.size() != func->parameters.size()) {
+            throw std::runtime_error("Error: Function '" + node.name + "' expects " + 
+                std::to_string(func->parameters.size()) + " argument(s) but " + 
+                std::to_string(node.arguments.size()) + " were given");
+        }
+        // Untyped parameters live in integer slots and registers, which would
+        // take a double's raw bits for an integer
+        for (size_t i = 0; i < node.arguments.size(); i++) {
+            const Parameter& param = func->parameters[i];
+            if (param.type.toString() == "unknown" && inferExprKind(node.arguments[i].get()) == ExprKind::FLOAT) {
+                throw std::runtime_error("Error: Function '" + node.name + "' is passed a float for untyped parameter '" +
+                    param.name + "'; declare it as " + param.name + ": float");
+            }
+        }
+    }
+    
+    // Expand a call in place: parameters become fresh slots in the caller's frame and
+    // return statements jump to the end of the expansion with the value in %rax
+    void generateInlineCall(FunctionCall& node, FunctionDeclaration* func) {
+        assembly << "    # Inlined call: " << node.name << "\n";
+        
+        // Arguments are evaluated in the caller's scope, left to right
+        for (size_t i = 0; i < node.arguments.size(); i++) {
+            pushArgument(node.arguments[i].get(), parameterType(func->parameters[i]) == "float", i);
+        }
+        
+        // Save caller state and enter the callee's scope
+        bool wasInFunction = inFunction;
+        auto savedLocalVars = localVariables;
+        auto savedDeclaredGlobal = declaredGlobal;
+        auto savedDeclaredLocal = declaredLocal;
+        int savedStackOffset = stackOffset;
+        std::string savedReturnLabel = currentReturnLabel;
+        std::string savedReturnKind = currentReturnKind;
+        auto savedBreakLabels = breakLabels;
+        auto savedContinueLabels = continueLabels;
+        auto savedAvailableValues = availableValues;
+        auto savedRepeatedValues = repeatedValues;
+        auto savedStringBuilders = stringBuilders;
+        auto savedTextVariables = textVariables;
+        auto savedGlobalVars = globalVariables;
+        
+        // The body shares the caller's frame, so a name it assigns without a
+        // global statement must not resolve to the caller's variable of that name
+        if (!func->isSingleExpression) {
+            std::unordered_set<std::string> assigned, shared;
+            AssignedNameCollector assignments(assigned);
+            GlobalNameCollector globals(shared);
+            for (auto& stmt : func->body) {
+                stmt->accept(assignments);
+                stmt->accept(globals);
+            }
+            for (const auto& name : assigned) {
+                if (!shared.count(name)) globalVariables.erase(name);
+            }
+        }
+        
+        inFunction = true;
+        localVariables.clear();
+        declaredGlobal.clear();
+        declaredLocal.clear();
+        currentReturnLabel = newLabel("inline_exit_");
+        currentReturnKind = "";
+        breakLabels = std::stack<std::string>();
+        continueLabels = std::stack<std::string>();
+        availableValues.clear();
+        repeatedValues.clear();
+        stringBuilders.clear();
+        textVariables.clear();
+        if (!func->isSingleExpression) repeatedValues = findRepeatedValues(func->body);
+        functionCallStack.push_back(functionScopeNames[func]);
+        inlineDepth++;
+        
+        // Bind parameters, typed exactly as the out-of-line version types them
+        std::vector<int> paramSlots;
+        for (const auto& param : func->parameters) {
+            allocateStackSlot();
+            VariableInfo paramInfo;
+            paramInfo.stackOffset = stackOffset;
+            paramInfo.type = parameterType(param);
+            paramInfo.isGlobal = false;
+            paramInfo.isConstant = false;
+            localVariables[param.name] = paramInfo;
+            paramSlots.push_back(stackOffset);
+        }
+        for (size_t i = func->parameters.size(); i-- > 0;) {
+            popTemp("%rax");
+            assembly << "    mov %rax, -" << paramSlots[i] << "(%rbp)  # Parameter " << func->parameters[i].name << "\n";
+        }
+        
+        assembly << profileCount(func, Profile::Entries);
+        
+        // The body's statements call into the runtime, so run it with %rsp 16-byte aligned
+        int bodyPadding = stackDepth % 16;
+        if (bodyPadding) {
+            assembly << "    sub $" << bodyPadding << ", %rsp  # Align inlined body\n";
+            stackDepth += bodyPadding;
+        }
+        
+        if (func->isSingleExpression) {
+            emitReturnValue(func->expression.get());
+        } else {
+            generateStatements(func->body);
         }
+        
+        assembly << currentReturnLabel << ":\n";
+        if (bodyPadding) {
+            assembly << "    add $" << bodyPadding << ", %rsp\n";
+            stackDepth -= bodyPadding;
+        }
+        
+        // Restore caller state
+        inlineDepth--;
+        functionCallStack.pop_back();
+        inFunction = wasInFunction;
+        localVariables = savedLocalVars;
+        for (auto& entry : savedGlobalVars) globalVariables.insert(entry);  // The hidden ones
+        declaredGlobal = savedDeclaredGlobal;
+        declaredLocal = savedDeclaredLocal;
+        stackOffset = savedStackOffset;
+        currentReturnLabel = savedReturnLabel;
+        currentReturnKind = savedReturnKind;
+        breakLabels = savedBreakLabels;
+        continueLabels = savedContinueLabels;
+        
+        // The caller's values survive what the body can do to them
+        availableValues = savedAvailableValues;
+        repeatedValues = savedRepeatedValues;
+        stringBuilders = savedStringBuilders;
+        textVariables = savedTextVariables;
+        CallEffectScanner effects;
+        if (func->isSingleExpression) {
+            func->expression->accept(effects);
+        } else {
+            for (auto& stmt : func->body) stmt->accept(effects);
+        }
+        if (effects.callsUserFunction) availableValues.clear();
+        if (effects.resizesLists) forgetLengthValues();
     }
     
     void visit(BinaryExpression& node) override {
+        if (emitReusableValue(node)) return;
+        
+        if (node.op == BinaryOp::AND || node.op == BinaryOp::OR) {
+            // Short-circuit: the right operand only runs when it decides the result
+            std::string falseLabel = newLabel("bool_false_");
+            std::string doneLabel = newLabel("bool_done_");
+            emitBranch(&node, false, falseLabel);
+            assembly << "    mov $1, %rax\n";
+            assembly << "    jmp " << doneLabel << "\n";
+            assembly << falseLabel << ":\n";
+            assembly << "    xor %eax, %eax\n";
+            assembly << doneLabel << ":\n";
+            return;
+        }
+        
         // Check for list operations first
         if (node.op == BinaryOp::ADD) {
             // Use type inference for robust two-sided validation
@@ -1202,12 +2653,12 @@ public:
                 // Evaluate left list
                 node.left->accept(*this);
                 assembly << "    mov %rax, %rdi  # First list as first argument\n";
-                assembly << "    push %rdi  # Save first list\n";
+                pushTemp("%rdi", "Save first list");
                 
                 // Evaluate right list
                 node.right->accept(*this);
                 assembly << "    mov %rax, %rsi  # Second list as second argument\n";
-                assembly << "    pop %rdi  # Restore first list\n";
+                popTemp("%rdi", "Restore first list");
                 
                 assembly << "    call list_concat  # Concatenate lists\n";
                 return;
@@ -1227,12 +2678,12 @@ public:
                 // Evaluate list
                 node.left->accept(*this);
                 assembly << "    mov %rax, %rdi  # List as first argument\n";
-                assembly << "    push %rdi  # Save list\n";
+                pushTemp("%rdi", "Save list");
                 
                 // Evaluate repeat count
                 node.right->accept(*this);
                 assembly << "    mov %rax, %rsi  # Repeat count as second argument\n";
-                assembly << "    pop %rdi  # Restore list\n";
+                popTemp("%rdi", "Restore list");
                 
                 assembly << "    call list_repeat  # Repeat list\n";
                 return;
@@ -1245,12 +2696,12 @@ public:
                 // Evaluate repeat count
                 node.left->accept(*this);
                 assembly << "    mov %rax, %rsi  # Repeat count as second argument\n";
-                assembly << "    push %rsi  # Save repeat count\n";
+                pushTemp("%rsi", "Save repeat count");
                 
                 // Evaluate list
                 node.right->accept(*this);
                 assembly << "    mov %rax, %rdi  # List as first argument\n";
-                assembly << "    pop %rsi  # Restore repeat count\n";
+                popTemp("%rsi", "Restore repeat count");
                 
                 assembly << "    call list_repeat  # Repeat list\n";
                 return;
@@ -1280,233 +2731,86 @@ public:
             // Evaluate left operand (string address)
             node.left->accept(*this);
             assembly << "    mov %rax, %rdi  # First string as first argument\n";
-            assembly << "    push %rdi  # Save first string\n";
+            pushTemp("%rdi", "Save first string");
             
             // Evaluate right operand (string address)
             node.right->accept(*this);
             assembly << "    mov %rax, %rsi  # Second string as second argument\n";
-            assembly << "    pop %rdi  # Restore first string\n";
-            
-            // Call strcmp to compare strings
-            assembly << "    call strcmp  # Compare strings\n";
+            popTemp("%rdi", "Restore first string");
             
-            // strcmp returns: 0 if equal, <0 if first < second, >0 if first > second
+            // Equality is a length check and a memcmp; ordering compares like
+            // strcmp, giving -1, 0 or 1
+            bool equality = node.op == BinaryOp::EQ || node.op == BinaryOp::NE;
+            emitAlignedCall(equality ? "orion_str_eq" : "orion_str_cmp");
             switch (node.op) {
                 case BinaryOp::EQ:
-                    // Set %rax to 1 if equal (strcmp returned 0), otherwise 0
-                    assembly << "    cmp $0, %eax  # Compare strcmp result with 0\n";
-                    assembly << "    sete %al      # Set %al to 1 if equal, 0 if not\n";
-                    assembly << "    movzx %al, %rax  # Zero-extend to full register\n";
                     break;
                 case BinaryOp::NE:
-                    // Set %rax to 1 if not equal (strcmp returned non-zero), otherwise 0
-                    assembly << "    cmp $0, %eax  # Compare strcmp result with 0\n";
-                    assembly << "    setne %al     # Set %al to 1 if not equal, 0 if equal\n";
-                    assembly << "    movzx %al, %rax  # Zero-extend to full register\n";
+                    assembly << "    xor $1, %rax  # Equal becomes 0, unequal 1\n";
                     break;
                 case BinaryOp::LT:
-                    assembly << "    test %rax, %rax\n";
-                    assembly << "    js slt_true_" << labelCounter << "\n";
-                    assembly << "    mov $str_false, %rax\n";
-                    assembly << "    jmp slt_done_" << labelCounter << "\n";
-                    assembly << "slt_true_" << labelCounter << ":" << "\n";
-                    assembly << "    mov $str_true, %rax\n";
-                    assembly << "slt_done_" << labelCounter << ":" << "\n";
-                    labelCounter++;
+                    assembly << "    cmp $0, %rax  # Compare ordering with 0\n";
+                    assembly << "    setl %al\n";
+                    assembly << "    movzx %al, %rax\n";
                     break;
                 case BinaryOp::LE:
-                    assembly << "    test %rax, %rax\n";
-                    assembly << "    jle sle_true_" << labelCounter << "\n";
-                    assembly << "    mov $str_false, %rax\n";
-                    assembly << "    jmp sle_done_" << labelCounter << "\n";
-                    assembly << "sle_true_" << labelCounter << ":" << "\n";
-                    assembly << "    mov $str_true, %rax\n";
-                    assembly << "sle_done_" << labelCounter << ":" << "\n";
-                    labelCounter++;
+                    assembly << "    cmp $0, %rax  # Compare ordering with 0\n";
+                    assembly << "    setle %al\n";
+                    assembly << "    movzx %al, %rax\n";
                     break;
                 case BinaryOp::GT:
-                    assembly << "    test %rax, %rax\n";
-                    assembly << "    jg sgt_true_" << labelCounter << "\n";
-                    assembly << "    mov $str_false, %rax\n";
-                    assembly << "    jmp sgt_done_" << labelCounter << "\n";
-                    assembly << "sgt_true_" << labelCounter << ":" << "\n";
-                    assembly << "    mov $str_true, %rax\n";
-                    assembly << "sgt_done_" << labelCounter << ":" << "\n";
-                    labelCounter++;
+                    assembly << "    cmp $0, %rax  # Compare ordering with 0\n";
+                    assembly << "    setg %al\n";
+                    assembly << "    movzx %al, %rax\n";
                     break;
                 case BinaryOp::GE:
-                    assembly << "    test %rax, %rax\n";
-                    assembly << "    jge sge_true_" << labelCounter << "\n";
-                    assembly << "    mov $str_false, %rax\n";
-                    assembly << "    jmp sge_done_" << labelCounter << "\n";
-                    assembly << "sge_true_" << labelCounter << ":" << "\n";
-                    assembly << "    mov $str_true, %rax\n";
-                    assembly << "sge_done_" << labelCounter << ":" << "\n";
-                    labelCounter++;
+                    assembly << "    cmp $0, %rax  # Compare ordering with 0\n";
+                    assembly << "    setge %al\n";
+                    assembly << "    movzx %al, %rax\n";
                     break;
                 default:
                     break;
             }
             return;
         }
-        
+
+        if (isStringConcat(&node)) {
+            // String concatenation: one allocation, each side copied once
+            emitStringConcat(node, "orion_str_concat");
+            return;
+        }
+
         // Check if either operand is a float
         bool leftIsFloat = isFloatExpression(node.left.get());
         bool rightIsFloat = isFloatExpression(node.right.get());
         bool isFloatOperation = leftIsFloat || rightIsFloat;
         
         if (isFloatOperation) {
-            // Handle floating-point arithmetic
-            assembly << "    # Floating-point binary operation\n";
-            
-            // Evaluate left operand
-            node.left->accept(*this);
-            if (leftIsFloat) {
-                assembly << "    movq %rax, %xmm0  # Load float left operand\n";
-            } else {
-                assembly << "    cvtsi2sd %rax, %xmm0  # Convert int to float (left)\n";
-            }
-            assembly << "    subq $8, %rsp\n";
-            assembly << "    movsd %xmm0, (%rsp)  # Save left operand on stack\n";
-            
-            // Evaluate right operand
-            node.right->accept(*this);
-            if (rightIsFloat) {
-                assembly << "    movq %rax, %xmm1  # Load float right operand\n";
-            } else {
-                assembly << "    cvtsi2sd %rax, %xmm1  # Convert int to float (right)\n";
-            }
-            
-            // Load left operand back
-            assembly << "    movsd (%rsp), %xmm0  # Restore left operand\n";
-            assembly << "    addq $8, %rsp\n";
-            
-            // Perform floating-point operation
-            switch (node.op) {
-                case BinaryOp::ADD:
-                    assembly << "    addsd %xmm1, %xmm0  # Float addition\n";
-                    break;
-                case BinaryOp::SUB:
-                    assembly << "    subsd %xmm1, %xmm0  # Float subtraction\n";
-                    break;
-                case BinaryOp::MUL:
-                    assembly << "    mulsd %xmm1, %xmm0  # Float multiplication\n";
-                    break;
-                case BinaryOp::DIV:
-                    assembly << "    divsd %xmm1, %xmm0  # Float division\n";
-                    break;
-                case BinaryOp::FLOOR_DIV:
-                    // Floor division: divide then apply floor function
-                    assembly << "    divsd %xmm1, %xmm0  # Float division\n";
-                    assembly << "    # Apply floor function\n";
-                    assembly << "    subq $8, %rsp  # Align stack\n";
-                    assembly << "    movsd %xmm0, (%rsp)  # Save division result\n";
-                    assembly << "    movsd (%rsp), %xmm0  # Load argument for floor\n";
-                    assembly << "    call floor  # Call C library floor function\n";
-                    assembly << "    addq $8, %rsp  # Restore stack\n";
-                    break;
-                case BinaryOp::MOD:
-                    // Float modulo using fmod function
-                    assembly << "    # Float modulo - save registers and call fmod\n";
-                    assembly << "    subq $16, %rsp  # Align stack\n";
-                    assembly << "    movsd %xmm0, (%rsp)  # Save first operand\n";
-                    assembly << "    movsd %xmm1, 8(%rsp)  # Save second operand\n";
-                    assembly << "    movsd (%rsp), %xmm0  # Load first arg for fmod\n";
-                    assembly << "    movsd 8(%rsp), %xmm1  # Load second arg for fmod\n";
-                    assembly << "    call fmod  # Call C library fmod function\n";
-                    assembly << "    addq $16, %rsp  # Restore stack\n";
-                    break;
-                case BinaryOp::POWER:
-                    // Float power using pow function
-                    assembly << "    # Float power - save registers and call pow\n";
-                    assembly << "    subq $16, %rsp  # Align stack\n";
-                    assembly << "    movsd %xmm0, (%rsp)  # Save base\n";
-                    assembly << "    movsd %xmm1, 8(%rsp)  # Save exponent\n";
-                    assembly << "    movsd (%rsp), %xmm0  # Load base for pow\n";
-                    assembly << "    movsd 8(%rsp), %xmm1  # Load exponent for pow\n";
-                    assembly << "    call pow  # Call C library pow function\n";
-                    assembly << "    addq $16, %rsp  # Restore stack\n";
-                    break;
-                case BinaryOp::EQ:
-                    assembly << "    comisd %xmm1, %xmm0\n";
-                    assembly << "    je feq_true_" << labelCounter << "\n";
-                    assembly << "    mov $str_false, %rax\n";
-                    assembly << "    jmp feq_done_" << labelCounter << "\n";
-                    assembly << "feq_true_" << labelCounter << ":\n";
-                    assembly << "    mov $str_true, %rax\n";
-                    assembly << "feq_done_" << labelCounter << ":\n";
-                    labelCounter++;
-                    return;
-                case BinaryOp::NE:
-                    assembly << "    comisd %xmm1, %xmm0\n";
-                    assembly << "    jne fne_true_" << labelCounter << "\n";
-                    assembly << "    mov $str_false, %rax\n";
-                    assembly << "    jmp fne_done_" << labelCounter << "\n";
-                    assembly << "fne_true_" << labelCounter << ":\n";
-                    assembly << "    mov $str_true, %rax\n";
-                    assembly << "fne_done_" << labelCounter << ":\n";
-                    labelCounter++;
-                    return;
-                case BinaryOp::LT:
-                    assembly << "    comisd %xmm1, %xmm0\n";
-                    assembly << "    jb flt_true_" << labelCounter << "\n";
-                    assembly << "    mov $str_false, %rax\n";
-                    assembly << "    jmp flt_done_" << labelCounter << "\n";
-                    assembly << "flt_true_" << labelCounter << ":\n";
-                    assembly << "    mov $str_true, %rax\n";
-                    assembly << "flt_done_" << labelCounter << ":\n";
-                    labelCounter++;
-                    return;
-                case BinaryOp::LE:
-                    assembly << "    comisd %xmm1, %xmm0\n";
-                    assembly << "    jbe fle_true_" << labelCounter << "\n";
-                    assembly << "    mov $str_false, %rax\n";
-                    assembly << "    jmp fle_done_" << labelCounter << "\n";
-                    assembly << "fle_true_" << labelCounter << ":\n";
-                    assembly << "    mov $str_true, %rax\n";
-                    assembly << "fle_done_" << labelCounter << ":\n";
-                    labelCounter++;
-                    return;
-                case BinaryOp::GT:
-                    assembly << "    comisd %xmm1, %xmm0\n";
-                    assembly << "    ja fgt_true_" << labelCounter << "\n";
-                    assembly << "    mov $str_false, %rax\n";
-                    assembly << "    jmp fgt_done_" << labelCounter << "\n";
-                    assembly << "fgt_true_" << labelCounter << ":\n";
-                    assembly << "    mov $str_true, %rax\n";
-                    assembly << "fgt_done_" << labelCounter << ":\n";
-                    labelCounter++;
-                    return;
-                case BinaryOp::GE:
-                    assembly << "    comisd %xmm1, %xmm0\n";
-                    assembly << "    jae fge_true_" << labelCounter << "\n";
-                    assembly << "    mov $str_false, %rax\n";
-                    assembly << "    jmp fge_done_" << labelCounter << "\n";
-                    assembly << "fge_true_" << labelCounter << ":\n";
-                    assembly << "    mov $str_true, %rax\n";
-                    assembly << "fge_done_" << labelCounter << ":\n";
-                    labelCounter++;
-                    return;
-                default:
-                    assembly << "    # Unsupported float operation - ERROR\n";
-                    assembly << "    mov $0, %rax  # Return 0 for unsupported operations\n";
-                    assembly << "    cvtsi2sd %rax, %xmm0  # Convert 0 to float\n";
-                    break;
+            // Floating-point arithmetic stays in XMM registers; only the final value
+            // crosses into %rax, as raw bits
+            if (isComparisonOp(node.op)) {
+                emitFloatOperands(node.left.get(), node.right.get());
+                emitFloatCompare(node.op);
+                assembly << "    movzx %al, %rax\n";
+                return;
             }
-            
-            // Store result back to %rax as raw bits
-            assembly << "    movq %xmm0, %rax  # Store float result\n";
+            emitFloatArithmetic(node);
+            assembly << "    movq %xmm0, %rax  # Float result\n";
         } else {
             // Handle integer arithmetic (original code)
             assembly << "    # Integer binary operation\n";
             
+            if (auto constant = dynamic_cast<IntLiteral*>(node.right.get())) {
+                if (emitIntegerOpByConstant(node, constant->value)) return;
+            }
+            
             // Evaluate left operand
             node.left->accept(*this);
-            assembly << "    push %rax\n";
+            pushTemp("%rax");
             
             // Evaluate right operand
             node.right->accept(*this);
-            assembly << "    pop %rbx\n";
+            popTemp("%rbx");
             
             // Perform operation
             switch (node.op) {
@@ -1523,36 +2827,69 @@ public:
                 case BinaryOp::DIV:
                     assembly << "    mov %rax, %rcx\n";
                     assembly << "    mov %rbx, %rax\n";
-                    assembly << "    xor %rdx, %rdx\n";
-                    assembly << "    idiv %rcx\n";
-                    break;
-                case BinaryOp::MOD:
-                    assembly << "    mov %rax, %rcx\n";
-                    assembly << "    mov %rbx, %rax\n";
-                    assembly << "    xor %rdx, %rdx\n";
+                    assembly << "    cqo\n";
                     assembly << "    idiv %rcx\n";
-                    assembly << "    mov %rdx, %rax\n";
                     break;
-                case BinaryOp::FLOOR_DIV:
-                    // Integer division (same as DIV for integers)
+                case BinaryOp::MOD:
+                case BinaryOp::FLOOR_DIV: {
+                    // idiv truncates; step the quotient down when the remainder
+                    // and divisor have opposite signs
+                    std::string doneLabel = newLabel("floor_done_");
                     assembly << "    mov %rax, %rcx\n";
                     assembly << "    mov %rbx, %rax\n";
-                    assembly << "    xor %rdx, %rdx\n";
+                    assembly << "    cqo\n";
                     assembly << "    idiv %rcx\n";
+                    assembly << "    test %rdx, %rdx\n";
+                    assembly << "    jz " << doneLabel << "\n";
+                    assembly << "    mov %rdx, %rsi\n";
+                    assembly << "    xor %rcx, %rsi\n";
+                    assembly << "    jns " << doneLabel << "\n";
+                    assembly << "    dec %rax\n";
+                    assembly << "    add %rcx, %rdx\n";
+                    assembly << doneLabel << ":\n";
+                    if (node.op == BinaryOp::MOD) {
+                        assembly << "    mov %rdx, %rax\n";
+                    }
                     break;
-                case BinaryOp::POWER:
-                    // Simple power implementation for small integers
+                }
+                case BinaryOp::POWER: {
+                    // Exponentiation by squaring
+                    std::string loopLabel = newLabel("pow_loop_");
+                    std::string skipLabel = newLabel("pow_skip_");
+                    std::string negativeLabel = newLabel("pow_negative_");
+                    std::string oneLabel = newLabel("pow_one_");
+                    std::string doneLabel = newLabel("pow_done_");
                     assembly << "    mov %rbx, %rcx  # base\n";
                     assembly << "    mov %rax, %rdx  # exponent\n";
                     assembly << "    mov $1, %rax    # result = 1\n";
-                    assembly << "power_loop:\n";
                     assembly << "    test %rdx, %rdx\n";
-                    assembly << "    jz power_done\n";
+                    assembly << "    jz " << doneLabel << "\n";
+                    assembly << "    js " << negativeLabel << "\n";
+                    assembly << loopLabel << ":\n";
+                    assembly << "    test $1, %dl\n";
+                    assembly << "    jz " << skipLabel << "\n";
                     assembly << "    imul %rcx, %rax\n";
-                    assembly << "    dec %rdx\n";
-                    assembly << "    jmp power_loop\n";
-                    assembly << "power_done:\n";
+                    assembly << skipLabel << ":\n";
+                    assembly << "    imul %rcx, %rcx\n";
+                    assembly << "    shr $1, %rdx\n";
+                    assembly << "    jnz " << loopLabel << "\n";
+                    assembly << "    jmp " << doneLabel << "\n";
+                    // A negative exponent truncates to 0 unless the base is 1 or -1
+                    assembly << negativeLabel << ":\n";
+                    assembly << "    cmp $1, %rcx\n";
+                    assembly << "    je " << doneLabel << "\n";
+                    assembly << "    xor %eax, %eax\n";
+                    assembly << "    cmp $-1, %rcx\n";
+                    assembly << "    jne " << doneLabel << "\n";
+                    assembly << "    test $1, %dl\n";
+                    assembly << "    jz " << oneLabel << "\n";
+                    assembly << "    mov $-1, %rax\n";
+                    assembly << "    jmp " << doneLabel << "\n";
+                    assembly << oneLabel << ":\n";
+                    assembly << "    mov $1, %rax\n";
+                    assembly << doneLabel << ":\n";
                     break;
+                }
                 case BinaryOp::EQ:
                     assembly << "    cmp %rax, %rbx\n";
                     assembly << "    sete %al\n";
@@ -1583,50 +2920,6 @@ public:
                     assembly << "    setge %al\n";
                     assembly << "    movzx %al, %rax\n";
                     break;
-                case BinaryOp::AND:
-                    // Logical AND: both operands must be truthy
-                    // Left operand is falsy if it's 0 or str_false
-                    assembly << "    cmp $0, %rbx\n";
-                    assembly << "    je and_false_" << labelCounter << "\n";
-                    assembly << "    cmp $str_false, %rbx\n";
-                    assembly << "    je and_false_" << labelCounter << "\n";
-                    // Left is truthy, check right operand
-                    assembly << "    cmp $0, %rax\n";
-                    assembly << "    je and_false_" << labelCounter << "\n";
-                    assembly << "    cmp $str_false, %rax\n";
-                    assembly << "    je and_false_" << labelCounter << "\n";
-                    // Both are truthy
-                    assembly << "    mov $str_true, %rax\n";
-                    assembly << "    jmp and_done_" << labelCounter << "\n";
-                    assembly << "and_false_" << labelCounter << ":\n";
-                    assembly << "    mov $str_false, %rax\n";
-                    assembly << "and_done_" << labelCounter << ":\n";
-                    labelCounter++;
-                    break;
-                case BinaryOp::OR:
-                    // Logical OR: either operand can be truthy
-                    // Check if left operand is truthy (not 0 and not str_false)
-                    assembly << "    cmp $0, %rbx\n";
-                    assembly << "    je or_check_right_" << labelCounter << "\n";
-                    assembly << "    cmp $str_false, %rbx\n";
-                    assembly << "    je or_check_right_" << labelCounter << "\n";
-                    // Left is truthy
-                    assembly << "    mov $str_true, %rax\n";
-                    assembly << "    jmp or_done_" << labelCounter << "\n";
-                    assembly << "or_check_right_" << labelCounter << ":\n";
-                    // Left is falsy, check right operand
-                    assembly << "    cmp $0, %rax\n";
-                    assembly << "    je or_false_" << labelCounter << "\n";
-                    assembly << "    cmp $str_false, %rax\n";
-                    assembly << "    je or_false_" << labelCounter << "\n";
-                    // Right is truthy
-                    assembly << "    mov $str_true, %rax\n";
-                    assembly << "    jmp or_done_" << labelCounter << "\n";
-                    assembly << "or_false_" << labelCounter << ":\n";
-                    assembly << "    mov $str_false, %rax\n";
-                    assembly << "or_done_" << labelCounter << ":\n";
-                    labelCounter++;
-                    break;
                 case BinaryOp::ASSIGN:
                     // Chain assignment: a = (b = 5)
                     // Evaluate RHS -> store to LHS -> return value in RAX
@@ -1647,7 +2940,7 @@ public:
                         VariableInfo* varInfo = lookupVariable(id->name);
                         if (!varInfo) {
                             // Variable doesn't exist, create it
-                            stackOffset += 8;
+                            allocateStackSlot();
                             VariableInfo newVarInfo;
                             newVarInfo.stackOffset = stackOffset;
                             newVarInfo.type = "unknown";
@@ -1665,6 +2958,8 @@ public:
                         
                         // Store value to variable directly from %rax
                         assembly << "    mov %rax, -" << varInfo->stackOffset << "(%rbp)  # store " << id->name << "\n";
+                        forgetValuesOf(id->name);
+                        noteStore(id->name, false);
                     } else {
                         throw std::runtime_error("Error: Left side of assignment must be a variable");
                     }
@@ -1688,152 +2983,83 @@ public:
     }
     
     void visit(InterpolatedString& node) override {
-        assembly << "    # Interpolated string - proper implementation\n";
+        // Upper bounds of the formatted parts (ORION_*_TEXT_MAX in runtime.c)
+        static constexpr int kIntTextMax = 20;
+        static constexpr int kBoolTextMax = 5;
+        static constexpr int kFloatTextMax = 320;
         
-        if (node.parts.empty()) {
-            // Empty interpolated string
-            int index = addStringLiteral("");
-            assembly << "    mov $str_" << index << ", %rax\n";
-            return;
+        bool hasExpression = false;
+        std::string text;
+        for (const auto& part : node.parts) {
+            if (part.isExpression) hasExpression = true;
+            else text += part.text;
         }
-        
-        if (node.parts.size() == 1) {
-            // Single part - handle directly
-            const auto& part = node.parts[0];
-            if (part.isExpression) {
-                // Evaluate expression
-                part.expression->accept(*this);
-                
-                // Convert expression result to string based on type
-                if (auto id = dynamic_cast<Identifier*>(part.expression.get())) {
-                    auto varInfo = lookupVariable(id->name);
-                    if (varInfo) {
-                        assembly << "    mov %rax, %rdi  # Expression result as argument\n";
-                        if (varInfo->type == "int") {
-                            assembly << "    call int_to_string  # Convert int to string\n";
-                        } else if (varInfo->type == "float") {
-                            assembly << "    call float_to_string  # Convert float to string\n";
-                        } else if (varInfo->type == "bool") {
-                            assembly << "    call bool_to_string  # Convert bool to string\n";
-                        } else if (varInfo->type == "string") {
-                            assembly << "    call string_to_string  # Copy string\n";
-                        } else {
-                            // Unknown type, treat as string pointer
-                            assembly << "    call string_to_string  # Copy as string\n";
-                        }
-                    } else {
-                        // Variable not found, treat as int by default
-                        assembly << "    mov %rax, %rdi  # Expression result as argument\n";
-                        assembly << "    call int_to_string  # Convert to string\n";
-                    }
-                } else {
-                    // Direct expression (literal)
-                    assembly << "    mov %rax, %rdi  # Expression result as argument\n";
-                    if (dynamic_cast<IntLiteral*>(part.expression.get())) {
-                        assembly << "    call int_to_string  # Convert int literal to string\n";
-                    } else if (dynamic_cast<FloatLiteral*>(part.expression.get())) {
-                        assembly << "    call float_to_string  # Convert float literal to string\n";
-                    } else if (dynamic_cast<BoolLiteral*>(part.expression.get())) {
-                        assembly << "    call bool_to_string  # Convert bool literal to string\n";
-                    } else if (dynamic_cast<StringLiteral*>(part.expression.get())) {
-                        assembly << "    call string_to_string  # Copy string literal\n";
-                    } else {
-                        // Default to int conversion for other expressions
-                        assembly << "    call int_to_string  # Convert expression to string\n";
-                    }
-                }
-            } else {
-                // Single text part
-                int textIndex = addStringLiteral(part.text);
-                assembly << "    mov $str_" << textIndex << ", %rax\n";
-            }
+        if (!hasExpression) {
+            // Only text: the string is a literal
+            int index = addStringLiteral(text);
+            assembly << "    mov $str_" << index << ", %rax  # Interpolated string without expressions\n";
             return;
         }
         
-        // Multiple parts - simplified concatenation approach
-        assembly << "    # Multiple parts - simplified concatenation\n";
-        
-        // For now, let's implement a simpler approach that builds the string incrementally
-        // Start with an empty result string
-        assembly << "    mov $0, %r12  # Initialize result string to null\n";
+        // Each part's value goes into an array on the stack and its tag into a
+        // string; orion_interpolate formats them all into one allocation
+        size_t count = node.parts.size();
+        int arrayBytes = static_cast<int>((count * 8 + 15) & ~size_t(15));
+        assembly << "    # Interpolated string with " << count << " parts\n";
+        assembly << "    sub $" << arrayBytes << ", %rsp  # Part values\n";
+        stackDepth += arrayBytes;
         
-        for (size_t i = 0; i < node.parts.size(); i++) {
+        std::string tags;
+        int fixedBytes = 0;
+        for (size_t i = 0; i < count; i++) {
             const auto& part = node.parts[i];
+            if (!part.isExpression) {
+                int textIndex = addStringLiteral(part.text);
+                assembly << "    movq $str_" << textIndex << ", " << 8 * i << "(%rsp)  # Text part\n";
+                tags += 't';
+                fixedBytes += static_cast<int>(part.text.size());
+                continue;
+            }
             
-            assembly << "    # Process part " << i << "\n";
+            // Evaluation leaves the stack as it found it, so the slot is still at 8*i(%rsp)
+            part.expression->accept(*this);
+            assembly << "    mov %rax, " << 8 * i << "(%rsp)  # Expression part\n";
             
-            if (part.isExpression) {
-                assembly << "    # Expression part " << i << "\n";
-                // Evaluate expression
-                part.expression->accept(*this);
-                
-                // Convert to string based on type
-                if (auto id = dynamic_cast<Identifier*>(part.expression.get())) {
-                    auto varInfo = lookupVariable(id->name);
-                    if (varInfo) {
-                        assembly << "    mov %rax, %rdi\n";
-                        if (varInfo->type == "int") {
-                            assembly << "    call int_to_string\n";
-                        } else if (varInfo->type == "float") {
-                            assembly << "    call float_to_string\n";
-                        } else if (varInfo->type == "bool") {
-                            assembly << "    call bool_to_string\n";
-                        } else if (varInfo->type == "string") {
-                            assembly << "    call string_to_string\n";
-                        } else {
-                            assembly << "    call string_to_string\n";
-                        }
-                    } else {
-                        assembly << "    mov %rax, %rdi\n";
-                        assembly << "    call int_to_string\n";
-                    }
-                } else {
-                    assembly << "    mov %rax, %rdi\n";
-                    if (dynamic_cast<IntLiteral*>(part.expression.get())) {
-                        assembly << "    call int_to_string\n";
-                    } else if (dynamic_cast<FloatLiteral*>(part.expression.get())) {
-                        assembly << "    call float_to_string\n";
-                    } else if (dynamic_cast<BoolLiteral*>(part.expression.get())) {
-                        assembly << "    call bool_to_string\n";
-                    } else if (dynamic_cast<StringLiteral*>(part.expression.get())) {
-                        assembly << "    call string_to_string\n";
+            // Format by variable type or literal kind; other expressions are ints
+            char tag = 'i';
+            if (auto id = dynamic_cast<Identifier*>(part.expression.get())) {
+                auto varInfo = lookupVariable(id->name);
+                if (varInfo) {
+                    if (varInfo->type == "int") {
+                        tag = 'i';
+                    } else if (varInfo->type == "float") {
+                        tag = 'f';
+                    } else if (varInfo->type == "bool") {
+                        tag = 'b';
                     } else {
-                        assembly << "    call int_to_string\n";
+                        tag = 's';  // Strings, and values of unknown type taken as strings
                     }
                 }
-            } else {
-                assembly << "    # Text part " << i << ": \"" << part.text << "\"\n";
-                // Text part - get string literal address
-                int textIndex = addStringLiteral(part.text);
-                assembly << "    mov $str_" << textIndex << ", %rax\n";
-                assembly << "    mov %rax, %rdi\n";
-                assembly << "    call string_to_string  # Copy string literal\n";
-            }
-            
-            // Now %rax contains the current part as a string
-            if (i == 0) {
-                // First part - just store it
-                assembly << "    mov %rax, %r12  # Store first part\n";
-            } else {
-                // Subsequent parts - concatenate with previous result
-                assembly << "    # Concatenate with previous result\n";
-                assembly << "    push %rax  # Save current part\n";
-                assembly << "    sub $16, %rsp  # Allocate space for 2 pointers\n";
-                assembly << "    mov %r12, 0(%rsp)  # Store previous result\n";
-                assembly << "    mov 16(%rsp), %rdi  # Get current part from stack\n";
-                assembly << "    mov %rdi, 8(%rsp)  # Store current part\n";
-                assembly << "    mov %rsp, %rdi  # Array of 2 string pointers\n";
-                assembly << "    mov $2, %rsi  # Number of parts to concatenate\n";
-                assembly << "    call string_concat_parts\n";
-                assembly << "    add $16, %rsp  # Clean up array space\n";
-                assembly << "    add $8, %rsp  # Clean up saved part\n";
-                assembly << "    mov %rax, %r12  # Store new result\n";
+            } else if (dynamic_cast<FloatLiteral*>(part.expression.get())) {
+                tag = 'f';
+            } else if (dynamic_cast<BoolLiteral*>(part.expression.get())) {
+                tag = 'b';
+            } else if (dynamic_cast<StringLiteral*>(part.expression.get())) {
+                tag = 's';
             }
+            tags += tag;
+            if (tag == 'i') fixedBytes += kIntTextMax;
+            if (tag == 'b') fixedBytes += kBoolTextMax;
+            if (tag == 'f') fixedBytes += kFloatTextMax;
         }
         
-        // Final result is in %r12
-        assembly << "    mov %r12, %rax  # Move result to return register\n";
-        assembly << "    # Multiple parts concatenation complete\n";
+        int tagsIndex = addStringLiteral(tags);
+        assembly << "    mov $str_" << tagsIndex << ", %rdi  # Part tags\n";
+        assembly << "    mov %rsp, %rsi  # Part values\n";
+        assembly << "    mov $" << fixedBytes << ", %rdx  # Bytes for all but the string parts\n";
+        emitAlignedCall("orion_interpolate");
+        assembly << "    add $" << arrayBytes << ", %rsp\n";
+        stackDepth -= arrayBytes;
     }
     
     void visit(Identifier& node) override {
@@ -1884,21 +3110,21 @@ public:
         for (size_t i = 0; i < node.values.size(); i++) {
             assembly << "    # Evaluating RHS value " << i << "\n";
             node.values[i]->accept(*this);
-            assembly << "    push %rax  # Save RHS value " << i << " on stack\n";
+            pushTemp("%rax", "Save RHS value " + std::to_string(i) + " on stack");
         }
         
         // Step 2: Assign to LHS variables in reverse order (since stack is LIFO)
         assembly << "    # Step 2: Assign to LHS variables\n";
         for (int i = node.targets.size() - 1; i >= 0; i--) {
             assembly << "    # Assigning to LHS target " << i << "\n";
-            assembly << "    pop %rax  # Get value " << i << " from stack\n";
+            popTemp("%rax", "Get value " + std::to_string(i) + " from stack");
             
             if (auto id = dynamic_cast<Identifier*>(node.targets[i].get())) {
                 // Find or create variable
                 VariableInfo* varInfo = lookupVariable(id->name);
                 if (!varInfo) {
                     // Variable doesn't exist, create it
-                    stackOffset += 8;
+                    allocateStackSlot();
                     VariableInfo newVarInfo;
                     newVarInfo.stackOffset = stackOffset;
                     newVarInfo.type = "unknown";
@@ -1916,6 +3142,8 @@ public:
                 
                 // Store the value
                 assembly << "    mov %rax, -" << varInfo->stackOffset << "(%rbp)  # store " << id->name << "\n";
+                forgetValuesOf(id->name);
+                noteStore(id->name, false);
             } else {
                 throw std::runtime_error("Error: Left side of tuple assignment must be variables");
             }
@@ -2007,23 +3235,18 @@ public:
     void visit(IndexAssignment& node) override {
         assembly << "    # Index assignment: list[index] = value\n";
         
-        // Evaluate the list expression
+        // Evaluate list, index and value in source order
         node.object->accept(*this);
-        assembly << "    mov %rax, %r12  # Save list pointer in %r12\n";
-        
-        // Evaluate the index expression
+        pushTemp("%rax", "Save list pointer");
         node.index->accept(*this);
-        assembly << "    mov %rax, %r13  # Save index in %r13\n";
-        
-        // Evaluate the value expression  
+        pushTemp("%rax", "Save index");
         node.value->accept(*this);
-        assembly << "    mov %rax, %rdx  # Value in %rdx (third argument)\n";
+        assembly << "    mov %rax, %r8  # Value\n";
+        popTemp("%rax", "Restore index");
+        popTemp("%rcx", "Restore list pointer");
         
-        // Call list_set(list, index, value)
-        assembly << "    mov %r12, %rdi  # List pointer as first argument\n";
-        assembly << "    mov %r13, %rsi  # Index as second argument\n";
-        assembly << "    # Value already in %rdx as third argument\n";
-        assembly << "    call list_set  # Set list[index] = value\n";
+        emitListElementAccess(node, node.index.get());
+        assembly << "    mov %r8, (%rcx,%rax,8)  # Store element\n";
     }
 
     // Stub implementations for other visitors
@@ -2034,70 +3257,236 @@ public:
         assembly << "    movq float_" << floatIndex << "(%rip), %rax\n";
     }
     void visit(BoolLiteral& node) override { 
-        assembly << "    mov $" << (node.value ? "str_true" : "str_false") << ", %rax\n";
+        assembly << "    mov $" << (node.value ? 1 : 0) << ", %rax\n";
     }
     void visit(UnaryExpression& node) override {
+        if (emitReusableValue(node)) return;
+        
         switch (node.op) {
             case UnaryOp::NOT:
-                // Logical NOT: flip boolean result
+                // Logical NOT: 1 for a falsy (zero) operand, 0 otherwise
                 node.operand->accept(*this);
-                // Check if operand result is falsy (0 or str_false)
-                assembly << "    cmp $0, %rax\n";
-                assembly << "    je not_true_" << labelCounter << "\n";
-                assembly << "    cmp $str_false, %rax\n";
-                assembly << "    je not_true_" << labelCounter << "\n";
-                // Operand is truthy, so NOT result is false
-                assembly << "    mov $str_false, %rax\n";
-                assembly << "    jmp not_done_" << labelCounter << "\n";
-                assembly << "not_true_" << labelCounter << ":\n";
-                // Operand is falsy, so NOT result is true
-                assembly << "    mov $str_true, %rax\n";
-                assembly << "not_done_" << labelCounter << ":\n";
-                labelCounter++;
+                assembly << "    test %rax, %rax\n";
+                assembly << "    sete %al\n";
+                assembly << "    movzx %al, %rax\n";
                 break;
             case UnaryOp::PLUS:
                 // Unary plus - just evaluate operand
                 node.operand->accept(*this);
                 break;
             case UnaryOp::MINUS:
-                // Unary minus - negate the operand
+                // Unary minus - negate the operand (floats flip the sign bit)
+                if (isFloatExpression(node.operand.get())) {
+                    emitFloat(&node);
+                    assembly << "    movq %xmm0, %rax\n";
+                    break;
+                }
                 node.operand->accept(*this);
                 assembly << "    neg %rax\n";
                 break;
         }
     }
     void visit(BlockStatement& node) override { 
-        for (auto& stmt : node.statements) {
+        generateStatements(node.statements);
+    }
+    
+    // Generates a statement list. Runs of out() calls whose text is known at
+    // compile time become one string and a single orion_write of its length.
+    void generateStatements(const std::vector<std::unique_ptr<Statement>>& statements, bool skipFunctions = false) {
+        std::string pending;
+        for (auto& stmt : statements) {
+            if (skipFunctions && dynamic_cast<FunctionDeclaration*>(stmt.get())) continue;
+            std::string text;
+            if (constantOutput(stmt.get(), text)) {
+                pending += text;
+                continue;
+            }
+            emitWrite(pending);
+            pending.clear();
             stmt->accept(*this);
         }
+        emitWrite(pending);
+    }
+    
+    void emitWrite(const std::string& text) {
+        if (text.empty()) return;
+        int index = addStringLiteral(text);
+        assembly << "    # Call out() with " << text.size() << " bytes of known output\n";
+        assembly << "    mov $str_" << index << ", %rdi\n";
+        assembly << "    mov $" << text.size() << ", %rsi\n";
+        assembly << "    call orion_write\n";
+    }
+    
+    // The exact text an out(...) statement prints, when its argument is a literal
+    // or a conversion of one; mirrors the formats visit(FunctionCall) uses
+    bool constantOutput(Statement* stmt, std::string& text) {
+        auto expr = dynamic_cast<ExpressionStatement*>(stmt);
+        auto call = expr ? dynamic_cast<FunctionCall*>(expr->expression.get()) : nullptr;
+        if (!call || call->name != "out") return false;
+        if (call->arguments.empty()) return true;
+        Expression* arg = call->arguments[0].get();
+        char buffer[512];
+        
+        if (auto conversion = dynamic_cast<FunctionCall*>(arg)) {
+            if (conversion->name == "dtype" && !conversion->arguments.empty()) {
+                std::string type = literalType(conversion->arguments[0].get());
+                if (type.empty()) {
+                    auto id = dynamic_cast<Identifier*>(conversion->arguments[0].get());
+                    if (!id) return false;
+                    auto varInfo = lookupVariable(id->name);
+                    if (!varInfo) return false;
+                    type = varInfo->type;
+                }
+                bool named = type == "int" || type == "string" || type == "bool" || type == "float" || type == "list";
+                text = "datatype: " + (named ? type : std::string("unknown")) + "\n";
+                return true;
+            }
+            if (conversion->arguments.size() != 1) return false;
+            Expression* value = conversion->arguments[0].get();
+            auto intLit = dynamic_cast<IntLiteral*>(value);
+            auto floatLit = dynamic_cast<FloatLiteral*>(value);
+            auto boolLit = dynamic_cast<BoolLiteral*>(value);
+            auto strLit = dynamic_cast<StringLiteral*>(value);
+            if (conversion->name == "str") {
+                if (intLit) {
+                    snprintf(buffer, sizeof buffer, "%ld", static_cast<long>(intLit->value));
+                } else if (floatLit) {
+                    text = shortestFloatText(floatLit->value);
+                    return true;
+                } else if (boolLit) {
+                    snprintf(buffer, sizeof buffer, "%s", boolLit->value ? "true" : "false");
+                } else if (strLit) {
+                    text = strLit->value.substr(0, strLit->value.find('\0'));
+                    return true;
+                } else {
+                    return false;
+                }
+                text = buffer;
+                return true;
+            }
+            if (conversion->name == "int") {
+                if (intLit) {
+                    snprintf(buffer, sizeof buffer, "%ld\n", static_cast<long>(intLit->value));
+                } else if (boolLit) {
+                    snprintf(buffer, sizeof buffer, "%d\n", boolLit->value ? 1 : 0);
+                } else {
+                    return false;
+                }
+                text = buffer;
+                return true;
+            }
+            if (conversion->name == "flt") {
+                if (intLit) {
+                    snprintf(buffer, sizeof buffer, "%.2f\n", static_cast<double>(intLit->value));
+                } else if (floatLit) {
+                    snprintf(buffer, sizeof buffer, "%.2f\n", floatLit->value);
+                } else {
+                    return false;
+                }
+                text = buffer;
+                return true;
+            }
+            return false;
+        }
+        
+        if (auto intLit = dynamic_cast<IntLiteral*>(arg)) {
+            snprintf(buffer, sizeof buffer, "%ld\n", static_cast<long>(intLit->value));
+        } else if (auto floatLit = dynamic_cast<FloatLiteral*>(arg)) {
+            snprintf(buffer, sizeof buffer, "%.2f\n", floatLit->value);
+        } else if (auto boolLit = dynamic_cast<BoolLiteral*>(arg)) {
+            snprintf(buffer, sizeof buffer, "%s", boolLit->value ? "True\n" : "False\n");
+        } else if (auto strLit = dynamic_cast<StringLiteral*>(arg)) {
+            // Strings print up to an embedded NUL
+            text = strLit->value.substr(0, strLit->value.find('\0'));
+            return true;
+        } else {
+            return false;
+        }
+        text = buffer;
+        return true;
     }
     void visit(ReturnStatement& node) override { 
-        if (node.value) node.value->accept(*this);
+        if (node.value && currentFunction && inlineDepth == 0 && stackDepth == 0) {
+            if (isSelfCall(node.value.get())) {
+                emitSelfTailCall(*static_cast<FunctionCall*>(node.value.get()));
+                return;
+            }
+            FunctionCall* tail = nullptr;
+            Expression* operand = nullptr;
+            BinaryOp op;
+            if (accumulatorSlot && matchAccumulatorReturn(node.value.get(), tail, operand, op)) {
+                // Fold the pending operation into the accumulator, then loop
+                operand->accept(*this);
+                if (accumulatorOp == BinaryOp::MUL) {
+                    assembly << "    imul -" << accumulatorSlot << "(%rbp), %rax\n";
+                    assembly << "    mov %rax, -" << accumulatorSlot << "(%rbp)  # Update accumulator\n";
+                } else {
+                    assembly << "    add %rax, -" << accumulatorSlot << "(%rbp)  # Update accumulator\n";
+                }
+                emitSelfTailCall(*tail);
+                return;
+            }
+            if (!accumulatorSlot && tryEmitSiblingTailCall(node.value.get())) {
+                return;
+            }
+        }
+        if (node.value) {
+            if (accumulatorSlot && inlineDepth == 0) {
+                // Accumulated functions only return integers
+                node.value->accept(*this);
+                std::string instr = accumulatorOp == BinaryOp::MUL ? "imul" : "add";
+                assembly << "    " << instr << " -" << accumulatorSlot << "(%rbp), %rax  # Apply accumulator\n";
+            } else {
+                emitReturnValue(node.value.get());
+            }
+        }
+        if (inFunction && !currentReturnLabel.empty()) {
+            // Temporaries are released by the epilogue, which restores %rsp from %rbp
+            assembly << "    jmp " << currentReturnLabel << "\n";
+        }
     }
     void visit(IfStatement& node) override {
         std::string elseLabel = "else_" + std::to_string(labelCounter);
         std::string endLabel = "end_if_" + std::to_string(labelCounter);
         labelCounter++;
         
-        // Evaluate condition
-        node.condition->accept(*this);
-        assembly << "    test %rax, %rax\n";
-        assembly << "    jz " << elseLabel << "\n";
+        assembly << profileCount(&node, Profile::Reached);
+        if (profile.isColdBranch(&node, true) || (node.elseBranch && profile.isColdBranch(&node, false))) {
+            emitIfWithColdBranch(node, profile.isColdBranch(&node, true));
+            return;
+        }
+        
+        // Condition jumps straight to the else branch when false
+        emitBranch(node.condition.get(), false, elseLabel);
+        auto beforeBranches = availableValues;
+        auto textBefore = textVariables;
         
         // Then branch
+        assembly << profileCount(&node, Profile::Taken);
         node.thenBranch->accept(*this);
+        if (!node.elseBranch) {
+            meetAvailableValues(beforeBranches);
+            meetTextVariables(textBefore);
+            assembly << elseLabel << ":\n";
+            return;
+        }
         assembly << "    jmp " << endLabel << "\n";
         
         // Else branch
+        auto afterThen = availableValues;
+        auto textAfterThen = textVariables;
+        availableValues = beforeBranches;
+        textVariables = textBefore;
         assembly << elseLabel << ":\n";
-        if (node.elseBranch) {
-            node.elseBranch->accept(*this);
-        }
+        node.elseBranch->accept(*this);
+        meetAvailableValues(afterThen);
+        meetTextVariables(textAfterThen);
         
         assembly << endLabel << ":\n";
     }
     void visit(WhileStatement& node) override {
         std::string loopLabel = "loop_" + std::to_string(labelCounter);
+        std::string bodyLabel = "loop_body_" + std::to_string(labelCounter);
         std::string endLabel = "end_loop_" + std::to_string(labelCounter);
         labelCounter++;
         
@@ -2105,22 +3494,29 @@ public:
         breakLabels.push(endLabel);
         continueLabels.push(loopLabel);
         
-        // Loop start
-        assembly << loopLabel << ":\n";
-        
-        // Evaluate condition
-        node.condition->accept(*this);
-        assembly << "    test %rax, %rax\n";
-        assembly << "    jz " << endLabel << "\n";
+        enterTextLoop(node.body.get(), nullptr);
+        auto textEntry = textVariables;
+        auto builders = startStringBuilders(node.body.get(), node.condition.get(), nullptr);
+        enterLoop(node.body.get(), node.condition.get(), nullptr);
+        auto loopEntry = availableValues;
         
-        // Loop body
+        // The condition sits below the body, so each iteration takes a single branch
+        assembly << profileCount(&node, Profile::Reached);
+        assembly << "    jmp " << loopLabel << "\n";
+        if (profile.isHotLoop(&node)) assembly << "    .p2align 4,,10\n";
+        assembly << bodyLabel << ":\n";
+        assembly << profileCount(&node, Profile::Iterations);
         node.body->accept(*this);
         
-        // Jump back to condition check
-        assembly << "    jmp " << loopLabel << "\n";
+        availableValues = loopEntry;
+        assembly << loopLabel << ":\n";
+        emitBranch(node.condition.get(), true, bodyLabel);
+        availableValues = loopEntry;
         
         // Loop end
         assembly << endLabel << ":\n";
+        stopStringBuilders(builders);
+        meetTextVariables(textEntry);
         
         // Restore previous loop labels
         breakLabels.pop();
@@ -2130,129 +3526,410 @@ public:
     // ForStatement removed - only ForInStatement is supported
     
     void visit(ForInStatement& node) override {
+        enterTextLoop(node.body.get(), &node.variable);
+        auto textEntry = textVariables;
+        auto builders = startStringBuilders(node.body.get(), nullptr, &node.variable);
+        generateForIn(node);
+        stopStringBuilders(builders);
+        meetTextVariables(textEntry);
+    }
+    
+    void generateForIn(ForInStatement& node) {
         std::string loopLabel = "forin_loop_" + std::to_string(labelCounter);
         std::string endLabel = "forin_end_" + std::to_string(labelCounter);
-        std::string isRangeLabel = "forin_is_range_" + std::to_string(labelCounter);
-        std::string isListLabel = "forin_is_list_" + std::to_string(labelCounter);
+        std::string nextLabel = "forin_next_" + std::to_string(labelCounter);
         labelCounter++;
+        assembly << profileCount(&node, Profile::Reached);
         
-        // Store current loop labels for break/continue
-        breakLabels.push(endLabel);
-        continueLabels.push(loopLabel);
+        VectorLoop vector;
+        bool vectorize = VectorLoop::match(node, vector) && vectorLoopTypesMatch(vector);
+        
+        // for i in range(...) is lowered to a counted loop without building the range
+        if (auto rangeCall = dynamic_cast<FunctionCall*>(node.iterable.get())) {
+            if (rangeCall->name == "range" && !findFunction("range") &&
+                !rangeCall->arguments.empty() && rangeCall->arguments.size() <= 3) {
+                generateRangeLoop(node, *rangeCall, loopLabel, endLabel, vectorize && !vector.overList ? &vector : nullptr);
+                return;
+            }
+        }
+        
+        // A short literal list of ints is unrolled without building the list
+        if (auto list = dynamic_cast<ListLiteral*>(node.iterable.get())) {
+            std::vector<int64_t> values;
+            for (auto& element : list->elements) {
+                auto literal = dynamic_cast<IntLiteral*>(element.get());
+                if (!literal) break;
+                values.push_back(literal->value);
+            }
+            if (values.size() == list->elements.size() &&
+                LoopUnrollPolicy::unrollFully(LoopUnrollPolicy::measure(node.body.get()), (int64_t)values.size())) {
+                emitUnrolledLoop(node, values, endLabel);
+                return;
+            }
+        }
+        
+        // Iterate over the list with inline loads, keeping the loop state in hidden slots.
+        // Unless the body may resize the list, its size and element array are loaded once.
+        ListResizeScanner resize;
+        node.body->accept(resize);
         
-        // Evaluate iterable (can be a list or range)
+        int listSlot = allocateStackSlot();
+        int indexSlot = allocateStackSlot();
+        int sizeSlot = resize.mayResize ? 0 : allocateStackSlot();
+        int dataSlot = resize.mayResize ? 0 : allocateStackSlot();
+        
+        assembly << "    # For-in loop over list object\n";
         node.iterable->accept(*this);
-        assembly << "    mov %rax, %r12  # Store iterable pointer\n";
-        assembly << "    mov $0, %r13    # Initialize index\n";
-        
-        // Check if iterable is a range or list by checking if it's a result of range() call
-        // We'll use a simple heuristic: check if the iterable is a FunctionCall with name "range"
-        if (auto funcCall = dynamic_cast<FunctionCall*>(node.iterable.get())) {
-            if (funcCall->name == "range") {
-                // This is a range object
-                assembly << "    # For-in loop over range object\n";
-                
-                // Get range length
-                assembly << "    mov %r12, %rdi  # Range pointer\n";
-                assembly << "    call range_len  # Get range length\n";
-                assembly << "    mov %rax, %r14  # Store range length\n";
-                
-                // Loop start
-                assembly << loopLabel << ":\n";
-                
-                // Check if index < length
-                assembly << "    cmp %r14, %r13\n";
-                assembly << "    jge " << endLabel << "\n";
-                
-                // Get current element: range[index]
-                assembly << "    mov %r12, %rdi  # Range pointer\n";
-                assembly << "    mov %r13, %rsi  # Index\n";
-                assembly << "    call range_get   # Get element at index\n";
-                
-                // Store current element in loop variable (range elements are integers)
-                setVariable(node.variable, "%rax", "int");
-                
-                // Execute loop body
-                node.body->accept(*this);
-                
-                // Increment index
-                assembly << "    inc %r13\n";
-                
-                // Jump back to loop condition
-                assembly << "    jmp " << loopLabel << "\n";
-                
-                // Loop end
-                assembly << endLabel << ":\n";
+        assembly << "    mov %rax, -" << listSlot << "(%rbp)  # List pointer\n";
+        assembly << "    movq $0, -" << indexSlot << "(%rbp)  # Index\n";
+        if (!resize.mayResize) {
+            assembly << "    mov (%rax), %rcx\n";
+            assembly << "    mov %rcx, -" << sizeSlot << "(%rbp)  # List length\n";
+            assembly << "    mov 16(%rax), %rcx\n";
+            assembly << "    mov %rcx, -" << dataSlot << "(%rbp)  # Element array\n";
+        }
+        
+        if (vectorize && vector.overList && !resize.mayResize) {
+            // The kernel runs every iteration; the variable is left at the last element
+            std::string emptyLabel = newLabel("vec_empty_");
+            emitVectorKernel(vector, {"-" + std::to_string(listSlot) + "(%rbp)"}, "-" + std::to_string(sizeSlot) + "(%rbp)");
+            assembly << "    mov -" << sizeSlot << "(%rbp), %rax\n";
+            assembly << "    test %rax, %rax\n";
+            assembly << "    jz " << emptyLabel << "\n";
+            assembly << "    mov -" << dataSlot << "(%rbp), %rcx\n";
+            assembly << "    mov -8(%rcx,%rax,8), %rax  # Last element\n";
+            setVariable(node.variable, "%rax", "int");
+            assembly << emptyLabel << ":\n";
+            return;
+        }
+        enterLoop(node.body.get(), nullptr, &node.variable);
+        auto loopEntry = availableValues;
+        
+        breakLabels.push(endLabel);
+        continueLabels.push(nextLabel);
+        
+        // Leaves the index in %rax and the element array in %rcx, jumping to label on jcc
+        auto emitIndexTest = [&](const std::string& jcc, const std::string& label) {
+            assembly << "    mov -" << indexSlot << "(%rbp), %rax\n";
+            if (resize.mayResize) {
+                // The body may append or pop, so the length and array are reloaded
+                assembly << "    mov -" << listSlot << "(%rbp), %rcx\n";
+                assembly << "    cmp (%rcx), %rax\n";
+                assembly << "    mov 16(%rcx), %rcx\n";
             } else {
-                // Default to list behavior for other function calls
-                assembly << "    # For-in loop over list object\n";
-                
-                // Get list length
-                assembly << "    mov (%r12), %r14  # Load list length\n";
-                
-                // Loop start
-                assembly << loopLabel << ":\n";
-                
-                // Check if index < length
-                assembly << "    cmp %r14, %r13\n";
-                assembly << "    jge " << endLabel << "\n";
-                
-                // Get current element: list[index]
-                assembly << "    mov %r12, %rdi  # List pointer\n";
-                assembly << "    mov %r13, %rsi  # Index\n";
-                assembly << "    call list_get   # Get element at index\n";
-                
-                // Store current element in loop variable (list elements can be any type, default to int)
+                assembly << "    cmp -" << sizeSlot << "(%rbp), %rax\n";
+                assembly << "    mov -" << dataSlot << "(%rbp), %rcx\n";
+            }
+            assembly << "    " << jcc << " " << label << "\n";
+        };
+        
+        // A loop the profile shows hot repeats the test below the body, so that each
+        // iteration runs straight through and takes a single branch
+        bool rotate = profile.isHotLoop(&node);
+        std::string bodyLabel = newLabel("forin_body_");
+        assembly << loopLabel << ":\n";
+        emitIndexTest("jge", endLabel);
+        if (rotate) {
+            assembly << "    .p2align 4,,10\n";
+            assembly << bodyLabel << ":\n";
+        }
+        assembly << "    mov (%rcx,%rax,8), %rax  # Current element\n";
+        
+        // Store current element in loop variable (list elements can be any type, default to int)
+        setVariable(node.variable, "%rax", "int");
+        
+        assembly << profileCount(&node, Profile::Iterations);
+        node.body->accept(*this);
+        
+        assembly << nextLabel << ":\n";
+        assembly << "    incq -" << indexSlot << "(%rbp)\n";
+        if (rotate) {
+            emitIndexTest("jl", bodyLabel);
+        } else {
+            assembly << "    jmp " << loopLabel << "\n";
+        }
+        assembly << endLabel << ":\n";
+        availableValues = loopEntry;
+        
+        breakLabels.pop();
+        continueLabels.pop();
+    }
+    
+    // Whether the variables of a vectorizable loop have the types its kernel works on
+    bool vectorLoopTypesMatch(const VectorLoop& loop) {
+        auto typeOf = [this](const std::string& name) {
+            VariableInfo* var = lookupVariable(name);
+            return var ? var->type : std::string();
+        };
+        bool accumulates = loop.kind == VectorLoop::Kind::Sum || loop.kind == VectorLoop::Kind::CountIf;
+        if (typeOf(loop.target) != (accumulates ? "int" : "list")) return false;
+        for (const auto& list : loop.sources) {
+            if (typeOf(list) != "list") return false;
+        }
+        auto bound = dynamic_cast<Identifier*>(loop.bound);
+        return !bound || typeOf(bound->name) == "int";
+    }
+    
+    // Runs the first `count` iterations of a vectorizable loop with its runtime
+    // kernel. `lists` holds the operands of the list pointers the loop reads
+    // (the destination first, for Add and Subtract).
+    void emitVectorKernel(const VectorLoop& loop, const std::vector<std::string>& lists, const std::string& count) {
+        auto loadData = [this](const std::string& list, const char* reg) {
+            assembly << "    mov " << list << ", %rax\n";
+            assembly << "    mov 16(%rax), " << reg << "  # Element array\n";
+        };
+        switch (loop.kind) {
+            case VectorLoop::Kind::Sum:
+                loadData(lists[0], "%rdi");
+                assembly << "    mov " << count << ", %rsi\n";
+                emitAlignedCall("orion_vec_sum");
+                break;
+            case VectorLoop::Kind::CountIf:
+                loadData(lists[0], "%rdi");
+                assembly << "    mov " << count << ", %rsi\n";
+                assembly << "    mov $" << loop.compare << ", %edx  # Comparison code\n";
+                if (auto literal = dynamic_cast<IntLiteral*>(loop.bound)) {
+                    assembly << "    mov $" << literal->value << ", %rcx\n";
+                } else {
+                    auto id = static_cast<Identifier*>(loop.bound);
+                    assembly << "    mov -" << lookupVariable(id->name)->stackOffset << "(%rbp), %rcx  # " << id->name << "\n";
+                }
+                emitAlignedCall("orion_vec_count_cmp");
+                break;
+            case VectorLoop::Kind::Add:
+            case VectorLoop::Kind::Subtract:
+                loadData(lists[0], "%rdi");
+                loadData(lists[1], "%rsi");
+                loadData(lists[2], "%rdx");
+                assembly << "    mov " << count << ", %rcx\n";
+                emitAlignedCall(loop.kind == VectorLoop::Kind::Add ? "orion_vec_add" : "orion_vec_sub");
+                return;
+        }
+        VariableInfo* target = lookupVariable(loop.target);
+        assembly << "    add %rax, -" << target->stackOffset << "(%rbp)  # " << loop.target << " += kernel result\n";
+        forgetValuesOf(loop.target);
+    }
+    
+    // Range form: the kernel takes the iterations every list has elements for, and
+    // the counted loop resumes after them. An index past the end of a list still
+    // reaches the checked scalar code.
+    void emitVectorPrefix(ForInStatement& node, const VectorLoop& loop, const std::string& stopOperand, int counterSlot) {
+        std::vector<std::string> lists;
+        if (loop.kind == VectorLoop::Kind::Add || loop.kind == VectorLoop::Kind::Subtract) {
+            lists.push_back(loop.target);
+        }
+        lists.insert(lists.end(), loop.sources.begin(), loop.sources.end());
+        for (auto& list : lists) {
+            list = "-" + std::to_string(lookupVariable(list)->stackOffset) + "(%rbp)";
+        }
+        
+        assembly << "    # Vectorized loop: iterations within every list\n";
+        assembly << "    mov " << stopOperand << ", %rax\n";
+        assembly << "    xor %ecx, %ecx\n";
+        assembly << "    test %rax, %rax\n";
+        assembly << "    cmovl %rcx, %rax\n";
+        for (const auto& list : lists) {
+            assembly << "    mov " << list << ", %rcx\n";
+            assembly << "    cmp (%rcx), %rax\n";
+            assembly << "    cmovg (%rcx), %rax  # Clamp to the list length\n";
+        }
+        std::string counter = "-" + std::to_string(counterSlot) + "(%rbp)";
+        assembly << "    mov %rax, " << counter << "\n";
+        emitVectorKernel(loop, lists, counter);
+        
+        // Leave the loop variable at the last index the kernel covered
+        std::string emptyLabel = newLabel("vec_empty_");
+        assembly << "    mov " << counter << ", %rax\n";
+        assembly << "    test %rax, %rax\n";
+        assembly << "    jz " << emptyLabel << "\n";
+        assembly << "    dec %rax\n";
+        setVariable(node.variable, "%rax", "int");
+        assembly << emptyLabel << ":\n";
+    }
+    
+    // Runs a loop body once per value, in order, without a loop. break leaves the
+    // sequence and continue skips to the next copy, so with either in the body only
+    // the values available on every path survive past a copy.
+    void emitUnrolledLoop(ForInStatement& node, const std::vector<int64_t>& values, const std::string& endLabel) {
+        assembly << "    # Loop unrolled: " << values.size() << " iterations\n";
+        if (values.empty()) return;
+        bool jumps = LoopUnrollPolicy::measure(node.body.get()).jumps;
+        enterLoop(node.body.get(), nullptr, &node.variable);
+        auto loopEntry = availableValues;
+        
+        breakLabels.push(endLabel);
+        for (int64_t value : values) {
+            std::string nextLabel = newLabel("unrolled_next_");
+            if (jumps) availableValues = loopEntry;
+            assembly << "    mov $" << value << ", %rax\n";
+            setVariable(node.variable, "%rax", "int");
+            continueLabels.push(nextLabel);
+            assembly << profileCount(&node, Profile::Iterations);
+            node.body->accept(*this);
+            continueLabels.pop();
+            if (jumps) assembly << nextLabel << ":\n";
+        }
+        breakLabels.pop();
+        
+        if (jumps) {
+            availableValues = loopEntry;
+            assembly << endLabel << ":\n";
+        }
+    }
+    
+    // Lowers `for v in range(start, stop, step)` to an induction variable kept in
+    // hidden stack slots. Bounds are evaluated once, in argument order, and the loop
+    // variable is written from the counter each iteration so the body may reassign it.
+    void generateRangeLoop(ForInStatement& node, FunctionCall& call,
+                           const std::string& loopLabel, const std::string& endLabel, const VectorLoop* vector) {
+        std::string bodyLabel = "forin_body_" + std::to_string(labelCounter);
+        std::string nextLabel = "forin_next_" + std::to_string(labelCounter);
+        std::string downLabel = "forin_down_" + std::to_string(labelCounter);
+        labelCounter++;
+        
+        LoopUnrollPolicy::Body body = LoopUnrollPolicy::measure(node.body.get());
+        int64_t constantStart = 0, constantStride = 1, trips = 0;
+        if (!vector && LoopUnrollPolicy::constantTripCount(call, constantStart, constantStride, trips) &&
+            LoopUnrollPolicy::unrollFully(body, trips)) {
+            std::vector<int64_t> values;
+            for (int64_t i = 0; i < trips; i++) values.push_back(constantStart + i * constantStride);
+            emitUnrolledLoop(node, values, endLabel);
+            return;
+        }
+        
+        auto& args = call.arguments;
+        Expression* startExpr = args.size() >= 2 ? args[0].get() : nullptr;
+        Expression* stopExpr = args.size() >= 2 ? args[1].get() : args[0].get();
+        Expression* stepExpr = args.size() == 3 ? args[2].get() : nullptr;
+        
+        auto constantOf = [](Expression* expr, int64_t& value) {
+            auto literal = dynamic_cast<IntLiteral*>(expr);
+            if (literal) value = literal->value;
+            return literal != nullptr;
+        };
+        int64_t stopValue = 0;
+        int64_t stepValue = 1;
+        bool constantStop = constantOf(stopExpr, stopValue);
+        bool constantStep = !stepExpr || constantOf(stepExpr, stepValue);
+        
+        int counterSlot = allocateStackSlot();
+        int stopSlot = constantStop ? 0 : allocateStackSlot();
+        int stepSlot = constantStep ? 0 : allocateStackSlot();
+        
+        assembly << "    # For-in loop over range: counted loop\n";
+        if (startExpr) {
+            startExpr->accept(*this);
+            assembly << "    mov %rax, -" << counterSlot << "(%rbp)  # Range counter\n";
+        } else {
+            assembly << "    movq $0, -" << counterSlot << "(%rbp)  # Range counter\n";
+        }
+        if (!constantStop) {
+            stopExpr->accept(*this);
+            assembly << "    mov %rax, -" << stopSlot << "(%rbp)  # Range stop\n";
+        }
+        if (stepExpr && !constantStep) {
+            stepExpr->accept(*this);
+            assembly << "    mov %rax, -" << stepSlot << "(%rbp)  # Range step\n";
+            std::string stepOkLabel = newLabel("forin_step_ok_");
+            assembly << "    test %rax, %rax\n";
+            assembly << "    jnz " << stepOkLabel << "\n";
+            assembly << "    call orion_range_step_error\n";
+            assembly << stepOkLabel << ":\n";
+        } else if (stepValue == 0) {
+            assembly << "    call orion_range_step_error\n";
+        }
+        
+        std::string stopOperand = constantStop ? "$" + std::to_string(stopValue)
+                                               : "-" + std::to_string(stopSlot) + "(%rbp)";
+        enterLoop(node.body.get(), nullptr, &node.variable);
+        auto loopEntry = availableValues;
+        if (vector) emitVectorPrefix(node, *vector, stopOperand, counterSlot);
+        
+        breakLabels.push(endLabel);
+        continueLabels.push(nextLabel);
+        
+        // Copies of the body run while the bound leaves room for all of them;
+        // the loop below takes the remaining iterations
+        int factor = vector || !constantStep ? 1 : LoopUnrollPolicy::unrollFactor(body);
+        int64_t span = (factor - 1) * stepValue;
+        if (factor > 1 && span >= INT32_MIN && span <= INT32_MAX) {
+            std::string unrolledLabel = newLabel("forin_unrolled_");
+            assembly << "    # Loop body unrolled " << factor << " times\n";
+            assembly << unrolledLabel << ":\n";
+            assembly << "    mov -" << counterSlot << "(%rbp), %rax\n";
+            assembly << "    add $" << span << ", %rax\n";
+            assembly << "    cmpq " << stopOperand << ", %rax\n";
+            assembly << (stepValue > 0 ? "    jge " : "    jle ") << loopLabel << "\n";
+            for (int copy = 0; copy < factor; copy++) {
+                std::string copyNextLabel = newLabel("forin_copy_next_");
+                availableValues = loopEntry;
+                assembly << "    mov -" << counterSlot << "(%rbp), %rax\n";
                 setVariable(node.variable, "%rax", "int");
-                
-                // Execute loop body
+                continueLabels.push(copyNextLabel);
+                assembly << profileCount(&node, Profile::Iterations);
                 node.body->accept(*this);
-                
-                // Increment index
-                assembly << "    inc %r13\n";
-                
-                // Jump back to loop condition
-                assembly << "    jmp " << loopLabel << "\n";
-                
-                // Loop end
-                assembly << endLabel << ":\n";
+                continueLabels.pop();
+                assembly << copyNextLabel << ":\n";
+                if (stepValue == 1) {
+                    assembly << "    incq -" << counterSlot << "(%rbp)\n";
+                } else {
+                    assembly << "    addq $" << stepValue << ", -" << counterSlot << "(%rbp)\n";
+                }
+            }
+            assembly << "    jmp " << unrolledLabel << "\n";
+            availableValues = loopEntry;
+        }
+        
+        // A loop the profile shows hot repeats the test below the body, so that each
+        // iteration runs straight through and takes a single branch
+        bool rotate = constantStep && profile.isHotLoop(&node);
+        assembly << loopLabel << ":\n";
+        assembly << "    mov -" << counterSlot << "(%rbp), %rax\n";
+        if (constantStep) {
+            assembly << "    cmpq " << stopOperand << ", %rax\n";
+            assembly << (stepValue > 0 ? "    jge " : "    jle ") << endLabel << "\n";
+            if (rotate) {
+                assembly << "    .p2align 4,,10\n";
+                assembly << bodyLabel << ":\n";
             }
         } else {
-            // Default to list behavior for non-function call iterables
-            assembly << "    # For-in loop over list object (default)\n";
-            
-            // Get list length
-            assembly << "    mov (%r12), %r14  # Load list length\n";
-            
-            // Loop start
-            assembly << loopLabel << ":\n";
-            
-            // Check if index < length
-            assembly << "    cmp %r14, %r13\n";
+            // Step sign is only known at run time
+            assembly << "    cmpq $0, -" << stepSlot << "(%rbp)\n";
+            assembly << "    jl " << downLabel << "\n";
+            assembly << "    cmpq " << stopOperand << ", %rax\n";
             assembly << "    jge " << endLabel << "\n";
-            
-            // Get current element: list[index]
-            assembly << "    mov %r12, %rdi  # List pointer\n";
-            assembly << "    mov %r13, %rsi  # Index\n";
-            assembly << "    call list_get   # Get element at index\n";
-            
-            // Store current element in loop variable (list elements can be any type, default to int)
-            setVariable(node.variable, "%rax", "int");
-            
-            // Execute loop body
-            node.body->accept(*this);
-            
-            // Increment index
-            assembly << "    inc %r13\n";
-            
-            // Jump back to loop condition
+            assembly << "    jmp " << bodyLabel << "\n";
+            assembly << downLabel << ":\n";
+            assembly << "    cmpq " << stopOperand << ", %rax\n";
+            assembly << "    jle " << endLabel << "\n";
+            assembly << bodyLabel << ":\n";
+        }
+        setVariable(node.variable, "%rax", "int");
+        
+        assembly << profileCount(&node, Profile::Iterations);
+        node.body->accept(*this);
+        
+        assembly << nextLabel << ":\n";
+        if (constantStep) {
+            if (stepValue == 1) {
+                assembly << "    incq -" << counterSlot << "(%rbp)\n";
+            } else {
+                assembly << "    addq $" << stepValue << ", -" << counterSlot << "(%rbp)\n";
+            }
+        } else {
+            assembly << "    mov -" << stepSlot << "(%rbp), %rax\n";
+            assembly << "    add %rax, -" << counterSlot << "(%rbp)\n";
+        }
+        if (rotate) {
+            assembly << "    mov -" << counterSlot << "(%rbp), %rax\n";
+            assembly << "    cmpq " << stopOperand << ", %rax\n";
+            assembly << (stepValue > 0 ? "    jl " : "    jg ") << bodyLabel << "\n";
+        } else {
             assembly << "    jmp " << loopLabel << "\n";
-            
-            // Loop end
-            assembly << endLabel << ":\n";
         }
+        assembly << endLabel << ":\n";
+        availableValues = loopEntry;
         
-        // Restore previous loop labels
         breakLabels.pop();
         continueLabels.pop();
     }
@@ -2278,6 +3955,7 @@ public:
     void visit(GlobalStatement& node) override {
         for (const std::string& varName : node.variables) {
             declaredGlobal.insert(varName);
+            forgetValuesOf(varName);
             assembly << "    # Global declaration: " << varName << "\n";
         }
     }
@@ -2285,6 +3963,7 @@ public:
     void visit(LocalStatement& node) override {
         for (const std::string& varName : node.variables) {
             declaredLocal.insert(varName);
+            forgetValuesOf(varName);
             assembly << "    # Local declaration: " << varName << "\n";
         }
     }
@@ -2309,9 +3988,9 @@ public:
         // Store each element in temporary array
         for (size_t i = 0; i < node.elements.size(); i++) {
             assembly << "    # Evaluating element " << i << "\n";
-            assembly << "    push %r12  # Save temp array pointer\n";
+            pushTemp("%r12", "Save temp array pointer");
             node.elements[i]->accept(*this);  // Element value in %rax
-            assembly << "    pop %r12  # Restore temp array pointer\n";
+            popTemp("%r12", "Restore temp array pointer");
             assembly << "    movq %rax, " << (i * 8) << "(%r12)  # Store in temp array\n";
         }
         
@@ -2321,26 +4000,22 @@ public:
         assembly << "    call list_from_data  # Create list from data\n";
         
         // Free temporary array - list_from_data made a copy
-        assembly << "    push %rax  # Save list pointer\n";
+        pushTemp("%rax", "Save list pointer");
         assembly << "    mov %r12, %rdi  # Temp array pointer\n";
         assembly << "    call orion_free  # Free temporary array\n";
-        assembly << "    pop %rax  # Restore list pointer\n";
+        popTemp("%rax", "Restore list pointer");
     }
     
     void visit(IndexExpression& node) override {
-        assembly << "    # Enhanced index expression with negative indexing support\n";
+        assembly << "    # Index expression: inline element load\n";
         
-        // Evaluate the object (list) - result in %rax
         node.object->accept(*this);
-        assembly << "    mov %rax, %rdi  # List pointer as first argument\n";
-        
-        // Evaluate the index - result in %rax
+        pushTemp("%rax", "Save list pointer");
         node.index->accept(*this);
-        assembly << "    mov %rax, %rsi  # Index as second argument\n";
+        popTemp("%rcx", "Restore list pointer");
         
-        // Call runtime function for safe indexing with negative support
-        assembly << "    call list_get  # Get element with bounds checking\n";
-        // Result is in %rax - no additional handling needed
+        emitListElementAccess(node, node.index.get());
+        assembly << "    mov (%rcx,%rax,8), %rax  # Load element\n";
     }
     
     void visit(StructDeclaration& node) override { }
@@ -2351,14 +4026,61 @@ public:
 } // namespace orion
 
 // Compiler main function
+static void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [options] <source-file>\n"
+              << "Options:\n"
+              << "  --no-peephole      Emit the generated assembly without peephole optimization\n"
+              << "  --peephole-stats   Report how often each peephole rule fired (stderr)\n"
+              << "  -fno-omit-frame-pointer\n"
+              << "                     Keep a %rbp frame in leaf functions too\n"
+              << "  --profile-generate[=FILE]\n"
+              << "                     Count executions and add them to FILE (orion.profile) at exit\n"
+              << "  --profile-use[=FILE]\n"
+              << "                     Inline and lay out code by the counts in FILE (orion.profile)\n"
+              << "  --no-partial-eval  Compile input-free programs instead of precomputing their output\n";
+}
+
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        std::cerr << "Usage: " << argv[0] << " <source-file>" << std::endl;
+    bool peephole = true;
+    bool peepholeStats = false;
+    bool keepFramePointer = false;
+    bool partialEval = true;
+    std::string profileGenerate;
+    std::string profileUse;
+    std::string filename;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--no-peephole") {
+            peephole = false;
+        } else if (arg == "--peephole-stats") {
+            peepholeStats = true;
+        } else if (arg == "-fno-omit-frame-pointer") {
+            keepFramePointer = true;
+        } else if (arg == "--no-partial-eval") {
+            partialEval = false;
+        } else if (arg == "--profile-generate" || arg.compare(0, 19, "--profile-generate=") == 0) {
+            profileGenerate = arg.size() > 19 ? arg.substr(19) : "orion.profile";
+        } else if (arg == "--profile-use" || arg.compare(0, 14, "--profile-use=") == 0) {
+            profileUse = arg.size() > 14 ? arg.substr(14) : "orion.profile";
+        } else if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else if (arg.size() > 1 && arg[0] == '-') {
+            std::cerr << "Error: Unknown option " << arg << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        } else if (filename.empty()) {
+            filename = arg;
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (filename.empty()) {
+        printUsage(argv[0]);
         return 1;
     }
     
-    std::string filename = argv[1];
-    
     try {
         // Read source file
         std::ifstream file(filename);
@@ -2387,13 +4109,40 @@ int main(int argc, char* argv[]) {
         orion::SimpleOrionParser parser(tokens);
         auto ast = parser.parse();
         
+        // Fold constant expressions and propagate known values before code generation
+        orion::ConstantFolder folder;
+        folder.run(*ast);
+        orion::DeadCodeEliminator deadCode;
+        deadCode.run(*ast);
+        
         // Note: Type checking would be done here for better error messages
         // but we'll focus on runtime error improvements for now
         
         // Step 3: Code generation
         orion::SimpleCodeGenerator codegen;
+        codegen.profileGeneratePath = profileGenerate;
+        codegen.profileUsePath = profileUse;
         std::string assembly = codegen.generate(*ast);
         
+        // A program that reads no input prints the same thing every run: run it
+        // now and emit just its output. Profiling builds must run the real code.
+        orion::PartialEvaluator evaluator;
+        std::string output;
+        if (partialEval && profileGenerate.empty() && profileUse.empty() &&
+            evaluator.run(*ast, codegen.returnTypes(), codegen.textUses(), output)) {
+            assembly = orion::PartialEvaluator::outputProgram(output);
+        } else {
+            // Clean up the instruction stream: redundant pushes, moves, reloads and jumps
+            if (peephole) {
+                orion::PeepholeOptimizer optimizer;
+                assembly = optimizer.run(assembly);
+                if (peepholeStats) optimizer.printStats(std::cerr);
+            }
+            
+            // Lay out the stack frames of the final code
+            assembly = orion::FrameLayout::lower(assembly, keepFramePointer);
+        }
+        
         // Step 4: Write assembly to file (KEEP FOR PROOF)
         std::string asmFile = "orion_asm.s";
         std::ofstream asmOut(asmFile);
@@ -0,0 +1,1293 @@
+#ifndef PARTIAL_EVAL_H
+#define PARTIAL_EVAL_H
+
+#include "ast.h"
+#include "ast_walker.h"
+#include "float_text.h"
+#include "strength_reduction.h"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace orion {
+
+// Whole-program partial evaluation. A program that never calls input() prints the
+// same output on every run, so the compiler runs it once, at compile time, and
+// emits an executable that only writes that output (outputProgram).
+//
+// The evaluator runs the program the way the generated code runs it, not the way
+// the source reads: each node does what the code generator emits for it, chosen
+// from the variable types the generator tracks in source order (bool variables
+// print as True/False, str() of a list variable hands back the list, ...). Wherever the
+// generated code's behaviour is not modelled it gives up, and the program is
+// compiled as usual:
+//   - a value in a representation the operation does not expect (a string added
+//     as an int, a float read as a string, a variable not yet assigned)
+//   - run-time errors: bad indices, division by zero, invalid int() strings
+//   - global/local statements, chain assignments and nested functions
+//   - a program that exceeds the step, memory, output or call depth budget
+class PartialEvaluator {
+public:
+    static constexpr int64_t kStepBudget = 2000000;        // Statements and expressions evaluated
+    static constexpr int64_t kMemoryBudget = 64ll << 20;   // Bytes of strings and list elements
+    static constexpr size_t kOutputBudget = 1 << 20;       // Bytes of output kept in the executable
+    static constexpr int kCallDepthBudget = 1000;
+
+    // Return types the code generator settled on for each function
+    using ReturnTypes = std::unordered_map<FunctionDeclaration*, std::string>;
+    // Whether the code generator treated each + and len() as text
+    using TextUses = std::unordered_map<Expression*, bool>;
+
+    // Runs `program` (after constant folding and dead code elimination, and
+    // after the code generator has seen it). True with everything it prints in
+    // `output`; false when it reads input or must be left to the generated code.
+    bool run(Program& program, const ReturnTypes& types, const TextUses& text, std::string& output) {
+        returnTypes = &types;
+        textUses = &text;
+        functions.clear();
+        untypedCalls.clear();
+        readTypes.clear();
+        storeTypes.clear();
+        kinds.clear();
+        globals.clear();
+        frame = &globals;
+        currentFunction = nullptr;
+        depth = 0;
+        steps = 0;
+        memory = 0;
+        printed.clear();
+        try {
+            if (!scan(program)) return false;
+            for (auto& stmt : program.statements) {
+                if (dynamic_cast<FunctionDeclaration*>(stmt.get())) continue;
+                if (exec(stmt.get()) != Flow::Normal) throw Fallback();
+            }
+        } catch (const Fallback&) {
+            return false;
+        }
+        output = printed;
+        return true;
+    }
+
+    // A complete program that writes `output` to standard output and exits
+    static std::string outputProgram(const std::string& output) {
+        std::ostringstream out;
+        out << ".section .rodata\n";
+        out << "output:\n";
+        for (size_t pos = 0; pos < output.size(); pos += 64) {
+            out << "    .ascii \"";
+            for (char c : output.substr(pos, 64)) {
+                unsigned char byte = static_cast<unsigned char>(c);
+                if (byte == '"' || byte == '\\') {
+                    out << '\\' << c;
+                } else if (byte >= 0x20 && byte < 0x7f) {
+                    out << c;
+                } else {
+                    char escape[8];
+                    std::snprintf(escape, sizeof escape, "\\%03o", byte);
+                    out << escape;
+                }
+            }
+            out << "\"\n";
+        }
+        out << "\n.section .text\n";
+        out << ".global main\n";
+        out << ".extern write\n\n";
+        out << "main:\n";
+        out << "    push %rbx\n";
+        out << "    push %r12\n";
+        out << "    sub $8, %rsp  # Align the stack for calls\n";
+        out << "    lea output(%rip), %rbx  # Next byte to write\n";
+        out << "    mov $" << output.size() << ", %r12  # Bytes left\n";
+        // A pipe may take fewer bytes than asked for
+        out << "write_loop:\n";
+        out << "    test %r12, %r12\n";
+        out << "    jz write_done\n";
+        out << "    mov $1, %edi  # Standard output\n";
+        out << "    mov %rbx, %rsi\n";
+        out << "    mov %r12, %rdx\n";
+        out << "    call write\n";
+        out << "    test %rax, %rax\n";
+        out << "    jle write_done\n";
+        out << "    add %rax, %rbx\n";
+        out << "    sub %rax, %r12\n";
+        out << "    jmp write_loop\n";
+        out << "write_done:\n";
+        out << "    add $8, %rsp\n";
+        out << "    pop %r12\n";
+        out << "    pop %rbx\n";
+        out << "    xor %eax, %eax\n";
+        out << "    ret\n";
+        return out.str();
+    }
+
+private:
+    struct Fallback {};
+
+    // A register's worth of generated-code value. Bools are ints; None stands for
+    // whatever %rax happens to hold (append's result, a missing return value).
+    struct Value {
+        enum Tag { None, Int, Float, String, List } tag = None;
+        int64_t i = 0;
+        double f = 0;
+        std::shared_ptr<const std::string> s;
+        std::shared_ptr<std::vector<Value>> list;
+    };
+
+    enum class Kind { Int, Float, Bool, String, List, Unknown };
+    enum class Flow { Normal, Break, Continue, Return };
+
+    using Types = std::unordered_map<std::string, std::string>;
+    using Frame = std::unordered_map<std::string, Value>;
+
+    // "?" marks a type that differs between the copies the code generator emits
+    // of a node, or that the evaluator cannot tell
+    static constexpr const char* kUnsure = "?";
+
+    const ReturnTypes* returnTypes = nullptr;
+    const TextUses* textUses = nullptr;
+    std::unordered_map<std::string, FunctionDeclaration*> functions;
+    std::unordered_set<FunctionCall*> untypedCalls;  // Calls generated before their callee's return type is known
+    std::unordered_map<Identifier*, std::string> readTypes;
+    std::unordered_map<VariableDeclaration*, std::string> storeTypes;
+    std::unordered_map<Expression*, Kind> kinds;
+
+    Frame globals;
+    Frame* frame = nullptr;
+    FunctionDeclaration* currentFunction = nullptr;
+    Value returned;
+    int depth = 0;
+    int64_t steps = 0;
+    int64_t memory = 0;
+    std::string printed;
+
+    // ---- Checks before running ----
+
+    // Rejects programs the evaluator does not model, then records the types
+    bool scan(Program& program) {
+        Scanner scanner;
+        for (auto& stmt : program.statements) {
+            if (auto func = dynamic_cast<FunctionDeclaration*>(stmt.get())) {
+                if (isBuiltin(func->name)) return false;
+                functions[func->name] = func;
+                scanner.scanFunction(*func);
+            } else {
+                stmt->accept(scanner);
+            }
+        }
+        if (scanner.readsInput || scanner.unsupported) return false;
+
+        // Function names are resolved like the code generator resolves them
+        // (the last definition wins)
+        findUntypedCalls();
+
+        for (const auto& entry : functions) {
+            FunctionDeclaration* func = entry.second;
+            Types types;
+            for (const auto& param : func->parameters) types[param.name] = parameterType(param);
+            if (func->isSingleExpression) {
+                recordReads(func->expression.get(), types);
+            } else {
+                typeStatements(func->body, types);
+            }
+        }
+        Types types;
+        for (auto& stmt : program.statements) {
+            if (!dynamic_cast<FunctionDeclaration*>(stmt.get())) typeStatement(stmt.get(), types);
+        }
+        return true;
+    }
+
+    class Scanner : public RecursiveASTVisitor {
+    public:
+        bool readsInput = false;
+        bool unsupported = false;
+
+        using RecursiveASTVisitor::visit;
+
+        void scanFunction(FunctionDeclaration& func) { RecursiveASTVisitor::visit(func); }
+
+        void visit(FunctionCall& node) override {
+            if (node.name == "input") readsInput = true;
+            RecursiveASTVisitor::visit(node);
+        }
+        void visit(StringLiteral& node) override {
+            if (node.value.find('\0') != std::string::npos) unsupported = true;
+        }
+        void visit(InterpolatedString& node) override {
+            for (const auto& part : node.parts) {
+                if (!part.isExpression && part.text.find('\0') != std::string::npos) unsupported = true;
+            }
+            RecursiveASTVisitor::visit(node);
+        }
+        void visit(BinaryExpression& node) override {
+            if (node.op == BinaryOp::ASSIGN) unsupported = true;
+            RecursiveASTVisitor::visit(node);
+        }
+        void visit(ChainAssignment&) override { unsupported = true; }
+        void visit(GlobalStatement&) override { unsupported = true; }
+        void visit(LocalStatement&) override { unsupported = true; }
+        void visit(FunctionDeclaration&) override { unsupported = true; }  // Only top-level functions
+    };
+
+    class CallCollector : public RecursiveASTVisitor {
+    public:
+        std::vector<FunctionCall*> calls;
+
+        using RecursiveASTVisitor::visit;
+
+        void visit(FunctionCall& node) override {
+            if (!isBuiltin(node.name)) calls.push_back(&node);
+            RecursiveASTVisitor::visit(node);
+        }
+    };
+
+    // Functions are generated callees first, so the only calls generated before
+    // their callee has a return type are those within a cycle of the call graph
+    void findUntypedCalls() {
+        std::unordered_map<FunctionDeclaration*, std::vector<FunctionCall*>> callsOf;
+        for (const auto& entry : functions) {
+            CallCollector collector;
+            collector.RecursiveASTVisitor::visit(*entry.second);
+            callsOf[entry.second] = collector.calls;
+        }
+        for (const auto& entry : callsOf) {
+            for (FunctionCall* call : entry.second) {
+                auto callee = functions.find(call->name);
+                if (callee == functions.end()) continue;
+                // Does the callee reach the caller?
+                std::unordered_set<FunctionDeclaration*> seen;
+                std::vector<FunctionDeclaration*> pending = {callee->second};
+                while (!pending.empty()) {
+                    FunctionDeclaration* func = pending.back();
+                    pending.pop_back();
+                    if (!seen.insert(func).second) continue;
+                    if (func == entry.first) {
+                        untypedCalls.insert(call);
+                        break;
+                    }
+                    for (FunctionCall* next : callsOf[func]) {
+                        auto it = functions.find(next->name);
+                        if (it != functions.end()) pending.push_back(it->second);
+                    }
+                }
+            }
+        }
+    }
+
+    // ---- Variable types, as the code generator tracks them ----
+
+    static void record(std::string& slot, bool fresh, const std::string& type) {
+        if (fresh) {
+            slot = type;
+        } else if (slot != type) {
+            slot = kUnsure;
+        }
+    }
+
+    class ReadRecorder : public RecursiveASTVisitor {
+    public:
+        ReadRecorder(PartialEvaluator& evaluator, const Types& types) : evaluator(evaluator), types(types) {}
+
+        using RecursiveASTVisitor::visit;
+
+        void visit(Identifier& node) override {
+            auto it = types.find(node.name);
+            auto slot = evaluator.readTypes.emplace(&node, "");
+            record(slot.first->second, slot.second, it == types.end() ? "" : it->second);
+        }
+
+    private:
+        PartialEvaluator& evaluator;
+        const Types& types;
+    };
+
+    void recordReads(Expression* expr, const Types& types) {
+        ReadRecorder recorder(*this, types);
+        expr->accept(recorder);
+    }
+
+    void typeStatements(const std::vector<std::unique_ptr<Statement>>& statements, Types& types) {
+        for (auto& stmt : statements) typeStatement(stmt.get(), types);
+    }
+
+    void typeStatement(Statement* stmt, Types& types) {
+        if (auto decl = dynamic_cast<VariableDeclaration*>(stmt)) {
+            if (!decl->initializer) return;
+            std::string type;
+            try {
+                type = declarationType(*decl, types);
+            } catch (const Fallback&) {
+                type = kUnsure;
+            }
+            auto slot = storeTypes.emplace(decl, "");
+            record(slot.first->second, slot.second, type);
+            // A new variable exists while its initializer runs; an existing one
+            // keeps its old type until the store
+            if (!types.count(decl->name)) types[decl->name] = type;
+            recordReads(decl->initializer.get(), types);
+            types[decl->name] = type;
+        } else if (auto expr = dynamic_cast<ExpressionStatement*>(stmt)) {
+            recordReads(expr->expression.get(), types);
+        } else if (auto tuple = dynamic_cast<TupleAssignment*>(stmt)) {
+            for (auto& value : tuple->values) recordReads(value.get(), types);
+            for (auto& target : tuple->targets) {
+                if (auto id = dynamic_cast<Identifier*>(target.get())) {
+                    if (!types.count(id->name)) types[id->name] = "unknown";
+                }
+            }
+        } else if (auto store = dynamic_cast<IndexAssignment*>(stmt)) {
+            recordReads(store->object.get(), types);
+            recordReads(store->index.get(), types);
+            recordReads(store->value.get(), types);
+        } else if (auto ret = dynamic_cast<ReturnStatement*>(stmt)) {
+            if (ret->value) recordReads(ret->value.get(), types);
+        } else if (auto branch = dynamic_cast<IfStatement*>(stmt)) {
+            // Both branches are generated in turn, with no merge afterwards
+            recordReads(branch->condition.get(), types);
+            typeStatement(branch->thenBranch.get(), types);
+            if (branch->elseBranch) typeStatement(branch->elseBranch.get(), types);
+        } else if (auto loop = dynamic_cast<WhileStatement*>(stmt)) {
+            // The condition is generated below the body
+            typeStatement(loop->body.get(), types);
+            recordReads(loop->condition.get(), types);
+        } else if (auto loop = dynamic_cast<ForInStatement*>(stmt)) {
+            recordReads(loop->iterable.get(), types);
+            typeForBody(*loop, types);
+        } else if (auto block = dynamic_cast<BlockStatement*>(stmt)) {
+            typeStatements(block->statements, types);
+        }
+    }
+
+    // An unrolled loop generates several copies of its body, each seeing the types
+    // the one before left, and a vectorized or empty one none at all. The body is
+    // typed until the types stop changing; a node typed differently in two copies,
+    // or a variable typed differently after them, is unsure.
+    void typeForBody(ForInStatement& loop, Types& types) {
+        Types after = types;
+        Types in = types;
+        for (;;) {
+            Types out = in;
+            out[loop.variable] = "int";
+            typeStatement(loop.body.get(), out);
+            after = merge(after, out);
+            Types next = merge(in, out);
+            if (next == in) break;
+            in = next;
+        }
+        types = after;
+    }
+
+    // Variables known on either side keep their type where the two agree
+    static Types merge(const Types& a, const Types& b) {
+        Types result = a;
+        for (const auto& entry : b) {
+            auto it = result.find(entry.first);
+            if (it == result.end()) {
+                result.insert(entry);
+            } else if (it->second != entry.second) {
+                it->second = kUnsure;
+            }
+        }
+        return result;
+    }
+
+    // The type the code generator gives the variable a declaration stores
+    std::string declarationType(VariableDeclaration& decl, const Types& types) {
+        Expression* init = decl.initializer.get();
+        if (dynamic_cast<IntLiteral*>(init)) return "int";
+        if (dynamic_cast<StringLiteral*>(init)) return "string";
+        if (dynamic_cast<BoolLiteral*>(init)) return "bool";
+        if (dynamic_cast<FloatLiteral*>(init)) return "float";
+        if (dynamic_cast<ListLiteral*>(init)) return "list";
+        if (auto id = dynamic_cast<Identifier*>(init)) {
+            auto it = types.find(id->name);
+            return it == types.end() ? "unknown" : it->second;
+        }
+        if (auto binary = dynamic_cast<BinaryExpression*>(init)) {
+            if (isComparison(binary->op) || binary->op == BinaryOp::AND || binary->op == BinaryOp::OR) return "bool";
+            if (binary->op == BinaryOp::ASSIGN) return "int";
+            if (inferKind(binary, &types, false) == Kind::String) return "string";
+            bool isFloat = inferKind(binary->left.get(), &types, false) == Kind::Float ||
+                           inferKind(binary->right.get(), &types, false) == Kind::Float;
+            return isFloat ? "float" : "int";
+        }
+        if (auto call = dynamic_cast<FunctionCall*>(init)) {
+            if (call->name == "input" || call->name == "dtype") return "string";
+            if (call->name == "len") return "int";
+            std::string type = typeName(inferKind(call, &types, true));
+            return type.empty() ? "string" : type;
+        }
+        std::string type = typeName(inferKind(init, &types, true));
+        return type.empty() ? "unknown" : type;
+    }
+
+    // The code generator's inferExprKind. While typing, identifiers take their type
+    // from `types`; while running, from the types recorded for each read. A strict
+    // caller needs the exact kind of an untyped call, which then is unsure unless
+    // the callee never had a return type; other callers treat int and bool results
+    // like unknown ones, as every operation does.
+    Kind inferKind(Expression* expr, const Types* types, bool strict) const {
+        if (dynamic_cast<IntLiteral*>(expr)) return Kind::Int;
+        if (dynamic_cast<FloatLiteral*>(expr)) return Kind::Float;
+        if (dynamic_cast<BoolLiteral*>(expr)) return Kind::Bool;
+        if (dynamic_cast<StringLiteral*>(expr)) return Kind::String;
+        if (dynamic_cast<InterpolatedString*>(expr)) return Kind::String;
+        if (dynamic_cast<ListLiteral*>(expr)) return Kind::List;
+        if (auto id = dynamic_cast<Identifier*>(expr)) {
+            if (types) {
+                auto it = types->find(id->name);
+                return it == types->end() ? Kind::Unknown : kindOfType(it->second);
+            }
+            auto it = readTypes.find(id);
+            if (it == readTypes.end()) throw Fallback();
+            return kindOfType(it->second);
+        }
+        if (auto call = dynamic_cast<FunctionCall*>(expr)) {
+            if (call->name == "len" || call->name == "int") return Kind::Int;
+            if (call->name == "str") return Kind::String;
+            if (call->name == "flt") return Kind::Float;
+            return kindOfType(returnType(*call, strict));
+        }
+        if (auto unary = dynamic_cast<UnaryExpression*>(expr)) {
+            if (unary->op == UnaryOp::NOT) return Kind::Bool;
+            return inferKind(unary->operand.get(), types, strict);
+        }
+        if (auto binary = dynamic_cast<BinaryExpression*>(expr)) {
+            if (isComparison(binary->op) || binary->op == BinaryOp::AND || binary->op == BinaryOp::OR) {
+                return Kind::Bool;
+            }
+            Kind left = inferKind(binary->left.get(), types, strict);
+            Kind right = inferKind(binary->right.get(), types, strict);
+            if (binary->op == BinaryOp::ADD && left == Kind::List && right == Kind::List) return Kind::List;
+            if (binary->op == BinaryOp::ADD && left == Kind::String && right == Kind::String && isText(binary)) {
+                return Kind::String;
+            }
+            if (binary->op == BinaryOp::MUL && ((left == Kind::List && right == Kind::Int) ||
+                                                (left == Kind::Int && right == Kind::List))) {
+                return Kind::List;
+            }
+            return left == Kind::Float || right == Kind::Float ? Kind::Float : Kind::Int;
+        }
+        return Kind::Unknown;
+    }
+
+    // The code generator's decision for a + or len(); it tracks which variables
+    // hold text as it goes, so a node it did not settle on one way is left to it
+    bool isText(Expression* node) const {
+        auto it = textUses->find(node);
+        if (it == textUses->end()) throw Fallback();
+        return it->second;
+    }
+
+    std::string returnType(FunctionCall& call, bool strict) const {
+        if (isBuiltin(call.name)) return "";
+        auto func = functions.find(call.name);
+        if (func == functions.end()) return "";
+        auto it = returnTypes->find(func->second);
+        std::string type = it == returnTypes->end() ? "" : it->second;
+        if (untypedCalls.count(&call) && !type.empty()) {
+            if (strict || (type != "int" && type != "bool")) throw Fallback();
+            return "";
+        }
+        return type;
+    }
+
+    static Kind kindOfType(const std::string& type) {
+        if (type == "int") return Kind::Int;
+        if (type == "float") return Kind::Float;
+        if (type == "bool") return Kind::Bool;
+        if (type == "string") return Kind::String;
+        if (type == "list") return Kind::List;
+        if (type == kUnsure) throw Fallback();
+        return Kind::Unknown;
+    }
+
+    static std::string typeName(Kind kind) {
+        switch (kind) {
+            case Kind::Int: return "int";
+            case Kind::Float: return "float";
+            case Kind::Bool: return "bool";
+            case Kind::String: return "string";
+            case Kind::List: return "list";
+            default: return "";
+        }
+    }
+
+    // Kind of an expression while running, computed once per node
+    Kind kind(Expression* expr) {
+        auto it = kinds.find(expr);
+        if (it != kinds.end()) return it->second;
+        Kind result = inferKind(expr, nullptr, false);
+        kinds[expr] = result;
+        return result;
+    }
+
+    // The type dtype() reports for a literal argument, or "" for anything else
+    static std::string literalType(Expression* expr) {
+        if (dynamic_cast<IntLiteral*>(expr)) return "int";
+        if (dynamic_cast<FloatLiteral*>(expr)) return "float";
+        if (dynamic_cast<StringLiteral*>(expr)) return "string";
+        if (dynamic_cast<BoolLiteral*>(expr)) return "bool";
+        if (dynamic_cast<ListLiteral*>(expr)) return "list";
+        return "";
+    }
+
+    const std::string& typeOf(Identifier& id) const {
+        auto it = readTypes.find(&id);
+        if (it == readTypes.end() || it->second == kUnsure) throw Fallback();
+        return it->second;
+    }
+
+    std::string storeType(VariableDeclaration& decl) const {
+        auto it = storeTypes.find(&decl);
+        if (it == storeTypes.end() || it->second == kUnsure) throw Fallback();
+        return it->second;
+    }
+
+    static std::string parameterType(const Parameter& param) {
+        return param.type.toString() != "unknown" ? param.type.toString() : "string";
+    }
+
+    static bool isComparison(BinaryOp op) {
+        return op == BinaryOp::EQ || op == BinaryOp::NE || op == BinaryOp::LT ||
+               op == BinaryOp::LE || op == BinaryOp::GT || op == BinaryOp::GE;
+    }
+
+    static bool isBuiltin(const std::string& name) {
+        return name == "str" || name == "int" || name == "flt" || name == "len" || name == "append" ||
+               name == "pop" || name == "range" || name == "out" || name == "input" || name == "dtype";
+    }
+
+    // ---- Budgets and values ----
+
+    void step() {
+        if (++steps > kStepBudget) throw Fallback();
+    }
+
+    void allocate(int64_t bytes) {
+        memory += bytes;
+        if (memory > kMemoryBudget) throw Fallback();
+    }
+
+    void print(const std::string& text) {
+        printed += text;
+        if (printed.size() > kOutputBudget) throw Fallback();
+    }
+
+    static Value intValue(int64_t i) {
+        Value value;
+        value.tag = Value::Int;
+        value.i = i;
+        return value;
+    }
+
+    static Value floatValue(double f) {
+        Value value;
+        value.tag = Value::Float;
+        value.f = f;
+        return value;
+    }
+
+    Value stringValue(std::string s) {
+        allocate(static_cast<int64_t>(s.size()) + 1);
+        Value value;
+        value.tag = Value::String;
+        value.s = std::make_shared<const std::string>(std::move(s));
+        return value;
+    }
+
+    Value listValue(std::vector<Value> elements) {
+        allocate(8 * static_cast<int64_t>(elements.size()) + 24);
+        Value value;
+        value.tag = Value::List;
+        value.list = std::make_shared<std::vector<Value>>(std::move(elements));
+        return value;
+    }
+
+    static int64_t asInt(const Value& value) {
+        if (value.tag != Value::Int) throw Fallback();
+        return value.i;
+    }
+
+    static double asFloat(const Value& value) {
+        if (value.tag != Value::Float) throw Fallback();
+        return value.f;
+    }
+
+    static const std::string& asString(const Value& value) {
+        if (value.tag != Value::String) throw Fallback();
+        return *value.s;
+    }
+
+    static std::vector<Value>& asList(const Value& value) {
+        if (value.tag != Value::List) throw Fallback();
+        return *value.list;
+    }
+
+    // test %rax, %rax
+    static bool isNonZero(const Value& value) {
+        switch (value.tag) {
+            case Value::Int: return value.i != 0;
+            case Value::Float: return value.f != 0 || std::signbit(value.f);
+            case Value::String:
+            case Value::List: return true;
+            default: throw Fallback();
+        }
+    }
+
+    static std::string format(const char* spec, int64_t value) {
+        char text[32];
+        std::snprintf(text, sizeof text, spec, static_cast<long>(value));
+        return text;
+    }
+
+    static std::string format(const char* spec, double value) {
+        char text[512];
+        std::snprintf(text, sizeof text, spec, value);
+        return text;
+    }
+
+    Value lookup(Identifier& id) {
+        auto it = frame->find(id.name);
+        if (it == frame->end()) throw Fallback();
+        return it->second;
+    }
+
+    // Element index after counting negative indices from the end
+    static size_t elementIndex(const std::vector<Value>& list, int64_t index) {
+        if (index < 0) index += static_cast<int64_t>(list.size());
+        if (index < 0 || index >= static_cast<int64_t>(list.size())) throw Fallback();
+        return static_cast<size_t>(index);
+    }
+
+    static int64_t wrap(uint64_t value) { return static_cast<int64_t>(value); }
+
+    // ---- Statements ----
+
+    Flow execAll(const std::vector<std::unique_ptr<Statement>>& statements) {
+        for (auto& stmt : statements) {
+            Flow flow = exec(stmt.get());
+            if (flow != Flow::Normal) return flow;
+        }
+        return Flow::Normal;
+    }
+
+    Flow exec(Statement* stmt) {
+        step();
+        if (auto decl = dynamic_cast<VariableDeclaration*>(stmt)) {
+            if (!decl->initializer) return Flow::Normal;
+            std::string type = storeType(*decl);
+            Value value = type == "float" ? floatValue(number(decl->initializer.get())) : evaluate(decl->initializer.get());
+            (*frame)[decl->name] = value;
+            return Flow::Normal;
+        }
+        if (auto expr = dynamic_cast<ExpressionStatement*>(stmt)) {
+            evaluate(expr->expression.get());
+            return Flow::Normal;
+        }
+        if (auto tuple = dynamic_cast<TupleAssignment*>(stmt)) {
+            if (tuple->targets.size() != tuple->values.size()) throw Fallback();
+            std::vector<Value> values;
+            for (auto& value : tuple->values) values.push_back(evaluate(value.get()));
+            // Stored last first, so a repeated target keeps its first value
+            for (size_t i = tuple->targets.size(); i-- > 0;) {
+                auto id = dynamic_cast<Identifier*>(tuple->targets[i].get());
+                if (!id) throw Fallback();
+                (*frame)[id->name] = values[i];
+            }
+            return Flow::Normal;
+        }
+        if (auto store = dynamic_cast<IndexAssignment*>(stmt)) {
+            Value list = evaluate(store->object.get());
+            int64_t index = asInt(evaluate(store->index.get()));
+            Value value = evaluate(store->value.get());
+            auto& elements = asList(list);
+            elements[elementIndex(elements, index)] = value;
+            return Flow::Normal;
+        }
+        if (auto ret = dynamic_cast<ReturnStatement*>(stmt)) {
+            if (!currentFunction) throw Fallback();
+            returned = ret->value ? returnValue(ret->value.get()) : Value();
+            return Flow::Return;
+        }
+        if (auto branch = dynamic_cast<IfStatement*>(stmt)) {
+            if (test(branch->condition.get())) return exec(branch->thenBranch.get());
+            return branch->elseBranch ? exec(branch->elseBranch.get()) : Flow::Normal;
+        }
+        if (auto loop = dynamic_cast<WhileStatement*>(stmt)) {
+            while (test(loop->condition.get())) {
+                Flow flow = exec(loop->body.get());
+                if (flow == Flow::Break) break;
+                if (flow == Flow::Return) return flow;
+            }
+            return Flow::Normal;
+        }
+        if (auto loop = dynamic_cast<ForInStatement*>(stmt)) {
+            return execFor(*loop);
+        }
+        if (auto block = dynamic_cast<BlockStatement*>(stmt)) {
+            return execAll(block->statements);
+        }
+        if (dynamic_cast<BreakStatement*>(stmt)) return Flow::Break;
+        if (dynamic_cast<ContinueStatement*>(stmt)) return Flow::Continue;
+        if (dynamic_cast<PassStatement*>(stmt) || dynamic_cast<StructDeclaration*>(stmt) ||
+            dynamic_cast<EnumDeclaration*>(stmt)) {
+            return Flow::Normal;
+        }
+        throw Fallback();
+    }
+
+    Flow execFor(ForInStatement& loop) {
+        auto range = dynamic_cast<FunctionCall*>(loop.iterable.get());
+        if (range && range->name == "range" && !range->arguments.empty() && range->arguments.size() <= 3) {
+            // A counted loop: bounds once, in argument order
+            auto& args = range->arguments;
+            int64_t start = args.size() >= 2 ? asInt(evaluate(args[0].get())) : 0;
+            int64_t stop = asInt(evaluate(args.size() >= 2 ? args[1].get() : args[0].get()));
+            int64_t stride = args.size() == 3 ? asInt(evaluate(args[2].get())) : 1;
+            if (stride == 0) throw Fallback();
+            // Unrolled loops test the bound several iterations ahead
+            const int64_t limit = int64_t(1) << 62;
+            if (start < -limit || start > limit || stop < -limit || stop > limit) throw Fallback();
+            for (int64_t counter = start; stride > 0 ? counter < stop : counter > stop; counter += stride) {
+                (*frame)[loop.variable] = intValue(counter);
+                Flow flow = exec(loop.body.get());
+                if (flow == Flow::Break) break;
+                if (flow == Flow::Return) return flow;
+            }
+            return Flow::Normal;
+        }
+
+        Value list = evaluate(loop.iterable.get());
+        auto& elements = asList(list);
+        size_t size = elements.size();
+        for (size_t i = 0; i < size; i++) {
+            (*frame)[loop.variable] = elements[i];
+            Flow flow = exec(loop.body.get());
+            if (flow == Flow::Break) break;
+            if (flow == Flow::Return) return flow;
+            // Loops over lists the body resizes are not modelled
+            if (elements.size() != size) throw Fallback();
+        }
+        return Flow::Normal;
+    }
+
+    // emitReturnValue. A function typed float hands its result back in %xmm0,
+    // which only a float return sets.
+    Value returnValue(Expression* expr) {
+        bool isFloat = kind(expr) == Kind::Float;
+        auto type = returnTypes->find(currentFunction);
+        if (!isFloat && type != returnTypes->end() && type->second == "float") throw Fallback();
+        return isFloat ? floatValue(number(expr)) : evaluate(expr);
+    }
+
+    // ---- Expressions ----
+
+    // What the generated code leaves in %rax
+    Value evaluate(Expression* expr) {
+        step();
+        if (auto literal = dynamic_cast<IntLiteral*>(expr)) return intValue(literal->value);
+        if (auto literal = dynamic_cast<FloatLiteral*>(expr)) return floatValue(literal->value);
+        if (auto literal = dynamic_cast<BoolLiteral*>(expr)) return intValue(literal->value ? 1 : 0);
+        if (auto literal = dynamic_cast<StringLiteral*>(expr)) return stringValue(literal->value);
+        if (auto id = dynamic_cast<Identifier*>(expr)) return lookup(*id);
+        if (auto binary = dynamic_cast<BinaryExpression*>(expr)) return evaluateBinary(*binary);
+        if (auto unary = dynamic_cast<UnaryExpression*>(expr)) {
+            switch (unary->op) {
+                case UnaryOp::NOT: return intValue(isNonZero(evaluate(unary->operand.get())) ? 0 : 1);
+                case UnaryOp::PLUS: return evaluate(unary->operand.get());
+                case UnaryOp::MINUS:
+                    if (kind(unary->operand.get()) == Kind::Float) return floatValue(number(unary));
+                    return intValue(wrap(0 - static_cast<uint64_t>(asInt(evaluate(unary->operand.get())))));
+            }
+        }
+        if (auto call = dynamic_cast<FunctionCall*>(expr)) return evaluateCall(*call);
+        if (auto list = dynamic_cast<ListLiteral*>(expr)) {
+            std::vector<Value> elements;
+            for (auto& element : list->elements) elements.push_back(evaluate(element.get()));
+            return listValue(std::move(elements));
+        }
+        if (auto access = dynamic_cast<IndexExpression*>(expr)) {
+            Value list = evaluate(access->object.get());
+            int64_t index = asInt(evaluate(access->index.get()));
+            auto& elements = asList(list);
+            return elements[elementIndex(elements, index)];
+        }
+        if (auto text = dynamic_cast<InterpolatedString*>(expr)) return interpolate(*text);
+        if (auto tuple = dynamic_cast<TupleExpression*>(expr)) {
+            return tuple->elements.empty() ? Value() : evaluate(tuple->elements.back().get());
+        }
+        throw Fallback();
+    }
+
+    Value evaluateBinary(BinaryExpression& node) {
+        if (node.op == BinaryOp::AND || node.op == BinaryOp::OR) return intValue(test(&node) ? 1 : 0);
+        Kind left = kind(node.left.get());
+        Kind right = kind(node.right.get());
+
+        if (node.op == BinaryOp::ADD && (left == Kind::List || right == Kind::List)) {
+            Value first = evaluate(node.left.get());
+            Value second = evaluate(node.right.get());
+            std::vector<Value> elements = asList(first);
+            const auto& tail = asList(second);
+            elements.insert(elements.end(), tail.begin(), tail.end());
+            return listValue(std::move(elements));
+        }
+        if (node.op == BinaryOp::MUL && ((left == Kind::List && right == Kind::Int) ||
+                                         (left == Kind::Int && right == Kind::List))) {
+            Value first = evaluate(node.left.get());
+            Value second = evaluate(node.right.get());
+            const Value& list = left == Kind::List ? first : second;
+            int64_t count = asInt(left == Kind::List ? second : first);
+            const auto& elements = asList(list);
+            if (count < 0) throw Fallback();
+            if (!elements.empty() && count > kMemoryBudget / 8 / static_cast<int64_t>(elements.size())) throw Fallback();
+            std::vector<Value> repeated;
+            allocate(8 * count * static_cast<int64_t>(elements.size()));
+            for (int64_t i = 0; i < count; i++) repeated.insert(repeated.end(), elements.begin(), elements.end());
+            return listValue(std::move(repeated));
+        }
+
+        if (left == Kind::String && right == Kind::String && isComparison(node.op)) {
+            Value first = evaluate(node.left.get());
+            Value second = evaluate(node.right.get());
+            int order = std::strcmp(asString(first).c_str(), asString(second).c_str());
+            return intValue(compare(node.op, order, 0) ? 1 : 0);
+        }
+
+        if (node.op == BinaryOp::ADD && kind(&node) == Kind::String) {
+            // Each side counts up to its first NUL, like the runtime's string length
+            Value first = evaluate(node.left.get());
+            Value second = evaluate(node.right.get());
+            const std::string& a = asString(first);
+            const std::string& b = asString(second);
+            return stringValue(a.substr(0, a.find('\0')) + b.substr(0, b.find('\0')));
+        }
+
+        if (left == Kind::Float || right == Kind::Float) {
+            if (isComparison(node.op)) {
+                double a = number(node.left.get());
+                double b = number(node.right.get());
+                return intValue(compare(node.op, a, b) ? 1 : 0);
+            }
+            return floatValue(floatArithmetic(node));
+        }
+
+        int64_t a = asInt(evaluate(node.left.get()));
+        int64_t b = asInt(evaluate(node.right.get()));
+        return intValue(integerOp(node.op, a, b));
+    }
+
+    template <typename T>
+    static bool compare(BinaryOp op, T a, T b) {
+        switch (op) {
+            case BinaryOp::EQ: return a == b;
+            case BinaryOp::NE: return !(a == b);
+            case BinaryOp::LT: return a < b;
+            case BinaryOp::LE: return a <= b;
+            case BinaryOp::GT: return a > b;
+            case BinaryOp::GE: return a >= b;
+            default: throw Fallback();
+        }
+    }
+
+    static int64_t integerOp(BinaryOp op, int64_t a, int64_t b) {
+        uint64_t ua = static_cast<uint64_t>(a), ub = static_cast<uint64_t>(b);
+        switch (op) {
+            case BinaryOp::ADD: return wrap(ua + ub);
+            case BinaryOp::SUB: return wrap(ua - ub);
+            case BinaryOp::MUL: return wrap(ua * ub);
+            case BinaryOp::DIV:
+            case BinaryOp::FLOOR_DIV:
+            case BinaryOp::MOD:
+                // Division by zero and INT64_MIN / -1 trap
+                if (b == 0 || (a == INT64_MIN && b == -1)) throw Fallback();
+                if (op == BinaryOp::DIV) return a / b;
+                return op == BinaryOp::FLOOR_DIV ? intmath::floorDiv(a, b) : intmath::floorMod(a, b);
+            case BinaryOp::POWER: {
+                if (b < 0) {
+                    if (a == 1) return 1;
+                    if (a == -1) return (b & 1) ? -1 : 1;
+                    return 0;
+                }
+                uint64_t result = 1;
+                for (uint64_t base = ua, exponent = ub; exponent; exponent >>= 1) {
+                    if (exponent & 1) result *= base;
+                    base *= base;
+                }
+                return wrap(result);
+            }
+            default:
+                if (isComparison(op)) return compare(op, a, b) ? 1 : 0;
+                throw Fallback();
+        }
+    }
+
+    double floatArithmetic(BinaryExpression& node) {
+        double a = number(node.left.get());
+        double b = number(node.right.get());
+        switch (node.op) {
+            case BinaryOp::ADD: return a + b;
+            case BinaryOp::SUB: return a - b;
+            case BinaryOp::MUL: return a * b;
+            case BinaryOp::DIV: return a / b;
+            case BinaryOp::FLOOR_DIV: return std::floor(a / b);
+            case BinaryOp::MOD: return std::fmod(a, b);
+            case BinaryOp::POWER: return std::pow(a, b);
+            default: throw Fallback();
+        }
+    }
+
+    // emitFloat: the expression as a double, in %xmm0
+    double number(Expression* expr) {
+        step();
+        if (auto literal = dynamic_cast<FloatLiteral*>(expr)) return literal->value;
+        if (auto literal = dynamic_cast<IntLiteral*>(expr)) return static_cast<double>(literal->value);
+        if (auto unary = dynamic_cast<UnaryExpression*>(expr)) {
+            if (unary->op == UnaryOp::PLUS) return number(unary->operand.get());
+            if (unary->op == UnaryOp::MINUS) return -number(unary->operand.get());
+        }
+        if (auto binary = dynamic_cast<BinaryExpression*>(expr)) {
+            if (!isComparison(binary->op) && binary->op != BinaryOp::AND && binary->op != BinaryOp::OR &&
+                kind(binary) == Kind::Float) {
+                return floatArithmetic(*binary);
+            }
+        }
+        if (auto call = dynamic_cast<FunctionCall*>(expr)) {
+            if (call->name == "flt" && call->arguments.size() == 1) return flt(*call);
+        }
+        Value value = evaluate(expr);
+        return kind(expr) == Kind::Float ? asFloat(value) : static_cast<double>(asInt(value));
+    }
+
+    // emitBranch: whether a condition holds
+    bool test(Expression* condition) {
+        step();
+        if (auto literal = dynamic_cast<BoolLiteral*>(condition)) return literal->value;
+        if (auto literal = dynamic_cast<IntLiteral*>(condition)) return literal->value != 0;
+        if (auto unary = dynamic_cast<UnaryExpression*>(condition)) {
+            if (unary->op == UnaryOp::NOT) return !test(unary->operand.get());
+        }
+        if (auto binary = dynamic_cast<BinaryExpression*>(condition)) {
+            if (binary->op == BinaryOp::AND) return test(binary->left.get()) && test(binary->right.get());
+            if (binary->op == BinaryOp::OR) return test(binary->left.get()) || test(binary->right.get());
+            if (isComparison(binary->op)) {
+                Kind left = kind(binary->left.get());
+                Kind right = kind(binary->right.get());
+                if (left == Kind::Float || right == Kind::Float) {
+                    double a = number(binary->left.get());
+                    double b = number(binary->right.get());
+                    return compare(binary->op, a, b);
+                }
+                if (!(left == Kind::String && right == Kind::String)) {
+                    int64_t a = asInt(evaluate(binary->left.get()));
+                    int64_t b = asInt(evaluate(binary->right.get()));
+                    return compare(binary->op, a, b);
+                }
+            }
+        }
+        return isNonZero(evaluate(condition));
+    }
+
+    // ---- Calls ----
+
+    Value evaluateCall(FunctionCall& node) {
+        auto& args = node.arguments;
+        if (node.name == "str") {
+            if (args.size() != 1) throw Fallback();
+            return str(*args[0]);
+        }
+        if (node.name == "int") {
+            if (args.size() != 1) throw Fallback();
+            return toInt(*args[0]);
+        }
+        if (node.name == "flt") {
+            if (args.size() != 1) throw Fallback();
+            return floatValue(flt(node));
+        }
+        if (node.name == "len") {
+            if (args.size() != 1) throw Fallback();
+            auto range = dynamic_cast<FunctionCall*>(args[0].get());
+            if (range && range->name == "range") return intValue(rangeLength(*range));
+            if (isText(&node)) {
+                Value value = evaluate(args[0].get());
+                const std::string& text = asString(value);
+                return intValue(static_cast<int64_t>(std::min(text.find('\0'), text.size())));
+            }
+            return intValue(static_cast<int64_t>(asList(evaluate(args[0].get())).size()));
+        }
+        if (node.name == "append") {
+            if (args.size() != 2) throw Fallback();
+            Value list = evaluate(args[0].get());
+            Value element = evaluate(args[1].get());
+            allocate(8);
+            asList(list).push_back(element);
+            return Value();
+        }
+        if (node.name == "pop") {
+            if (args.size() != 1) throw Fallback();
+            Value list = evaluate(args[0].get());
+            auto& elements = asList(list);
+            if (elements.empty()) throw Fallback();
+            Value last = elements.back();
+            elements.pop_back();
+            return last;
+        }
+        if (node.name == "out") {
+            if (!args.empty()) out(*args[0]);
+            return Value();
+        }
+        if (node.name == "dtype") {
+            if (args.empty()) return Value();
+            std::string type = literalType(args[0].get());
+            if (type.empty()) {
+                auto id = dynamic_cast<Identifier*>(args[0].get());
+                if (!id) return Value();
+                type = typeOf(*id);
+            }
+            bool named = type == "int" || type == "string" || type == "bool" || type == "float";
+            return stringValue("datatype: " + (named ? type : std::string("unknown")) + "\n");
+        }
+        if (isBuiltin(node.name)) throw Fallback();  // range() objects and input()
+        return callFunction(node);
+    }
+
+    Value callFunction(FunctionCall& node) {
+        auto it = functions.find(node.name);
+        if (it == functions.end()) throw Fallback();
+        FunctionDeclaration* func = it->second;
+        if (node.arguments.size() != func->parameters.size()) throw Fallback();
+
+        // Float parameters receive a double even for an integer argument
+        Frame locals;
+        std::vector<Value> values;
+        for (size_t i = 0; i < node.arguments.size(); i++) {
+            Expression* arg = node.arguments[i].get();
+            values.push_back(parameterType(func->parameters[i]) == "float" ? floatValue(number(arg)) : evaluate(arg));
+        }
+        for (size_t i = 0; i < values.size(); i++) locals[func->parameters[i].name] = values[i];
+
+        if (++depth > kCallDepthBudget) throw Fallback();
+        Frame* savedFrame = frame;
+        FunctionDeclaration* savedFunction = currentFunction;
+        frame = &locals;
+        currentFunction = func;
+        Value result;
+        if (func->isSingleExpression) {
+            result = returnValue(func->expression.get());
+        } else {
+            Flow flow = execAll(func->body);
+            if (flow == Flow::Return) {
+                result = returned;
+            } else if (flow != Flow::Normal) {
+                throw Fallback();
+            }
+        }
+        frame = savedFrame;
+        currentFunction = savedFunction;
+        depth--;
+        return result;
+    }
+
+    // range_len of range(...)
+    int64_t rangeLength(FunctionCall& range) {
+        auto& args = range.arguments;
+        if (args.empty() || args.size() > 3) throw Fallback();
+        int64_t start = args.size() >= 2 ? asInt(evaluate(args[0].get())) : 0;
+        int64_t stop = asInt(evaluate(args.size() >= 2 ? args[1].get() : args[0].get()));
+        int64_t stride = args.size() == 3 ? asInt(evaluate(args[2].get())) : 1;
+        if (stride == 0) throw Fallback();
+        if ((stride > 0 && start >= stop) || (stride < 0 && start <= stop)) return 0;
+        __int128 diff = static_cast<__int128>(stop) - start;
+        __int128 size = stride > 0 ? (diff + stride - 1) / stride : (diff + stride + 1) / stride;
+        if (diff > INT64_MAX || diff < INT64_MIN) throw Fallback();  // The runtime overflows
+        return size < 0 ? 0 : static_cast<int64_t>(size);
+    }
+
+    // str(x)
+    Value str(Expression& arg) {
+        if (kind(&arg) == Kind::Float) return stringValue(shortestFloatText(number(&arg)));
+        Value value = evaluate(&arg);
+        auto boolText = [this](const Value& v) {
+            return stringValue(static_cast<int32_t>(asInt(v)) ? "true" : "false");
+        };
+        if (dynamic_cast<BoolLiteral*>(&arg)) return boolText(value);
+        if (dynamic_cast<StringLiteral*>(&arg)) return value;
+        if (auto id = dynamic_cast<Identifier*>(&arg)) {
+            const std::string& type = typeOf(*id);
+            if (type == "int") return stringValue(format("%ld", asInt(value)));
+            if (type == "bool") return boolText(value);
+            return value;  // Strings as they are; other types are not converted
+        }
+        return stringValue(format("%ld", asInt(value)));
+    }
+
+    // int(x)
+    Value toInt(Expression& arg) {
+        Value value = evaluate(&arg);
+        auto fromFloat = [](double f) {
+            // cvttsd2si: out of range and NaN give INT64_MIN
+            if (!(f > -9223372036854775808.0 && f < 9223372036854775808.0)) throw Fallback();
+            return intValue(static_cast<int64_t>(f));
+        };
+        auto fromBool = [](const Value& v) { return intValue(static_cast<int32_t>(asInt(v)) ? 1 : 0); };
+        if (dynamic_cast<IntLiteral*>(&arg)) return value;
+        if (dynamic_cast<FloatLiteral*>(&arg)) return fromFloat(asFloat(value));
+        if (dynamic_cast<BoolLiteral*>(&arg)) return fromBool(value);
+        if (dynamic_cast<StringLiteral*>(&arg)) return intValue(parseInt(asString(value)));
+        if (auto id = dynamic_cast<Identifier*>(&arg)) {
+            const std::string& type = typeOf(*id);
+            if (type == "float") return fromFloat(asFloat(value));
+            if (type == "bool") return fromBool(value);
+            if (type == "string") return intValue(parseInt(asString(value)));
+            return value;
+        }
+        throw Fallback();  // The generated code calls a helper the runtime lacks
+    }
+
+    // __orion_string_to_int
+    static int64_t parseInt(const std::string& text) {
+        char* end = nullptr;
+        errno = 0;
+        long long result = std::strtoll(text.c_str(), &end, 10);
+        if (errno == ERANGE || end == text.c_str() || *end != '\0') throw Fallback();
+        return result;
+    }
+
+    // emitFltCall: flt(x) as a double
+    double flt(FunctionCall& call) {
+        Expression* arg = call.arguments[0].get();
+        Kind argKind = kind(arg);
+        if (argKind == Kind::Int || argKind == Kind::Float || argKind == Kind::Bool) return number(arg);
+        Value value = evaluate(arg);
+        if (argKind != Kind::String) return static_cast<double>(asInt(value));
+        const std::string& text = asString(value);
+        char* end = nullptr;
+        errno = 0;
+        double result = std::strtod(text.c_str(), &end);
+        if (errno == ERANGE || end == text.c_str() || *end != '\0') throw Fallback();
+        return result;
+    }
+
+    // out(x), printing with the format the code generator picks
+    void out(Expression& arg) {
+        static const char* const boolText[] = {"False\n", "True\n"};
+        auto printInt = [this](int64_t value) { print(format("%ld\n", value)); };
+        if (auto call = dynamic_cast<FunctionCall*>(&arg)) {
+            if (call->name == "str") {
+                print(asString(evaluate(call)));
+                return;
+            }
+            if (call->name == "int") {
+                printInt(asInt(evaluate(call)));
+                return;
+            }
+            if (call->name == "flt") {
+                if (call->arguments.size() != 1) throw Fallback();
+                print(format("%.2f\n", flt(*call)));
+                return;
+            }
+            if (call->name == "dtype" && !call->arguments.empty()) {
+                std::string type = literalType(call->arguments[0].get());
+                auto id = dynamic_cast<Identifier*>(call->arguments[0].get());
+                if (type.empty() && id) type = typeOf(*id);
+                if (!type.empty()) {
+                    bool named = type == "int" || type == "string" || type == "bool" || type == "float" || type == "list";
+                    print("datatype: " + (named ? type : std::string("unknown")) + "\n");
+                }
+                return;
+            }
+        }
+        if (auto literal = dynamic_cast<IntLiteral*>(&arg)) {
+            printInt(literal->value);
+            return;
+        }
+        if (auto literal = dynamic_cast<StringLiteral*>(&arg)) {
+            print(literal->value);
+            return;
+        }
+        if (auto id = dynamic_cast<Identifier*>(&arg)) {
+            const std::string& type = typeOf(*id);
+            Value value = lookup(*id);
+            if (type == "int") {
+                printInt(asInt(value));
+            } else if (type == "bool") {
+                print(boolText[isNonZero(value)]);
+            } else if (type == "float") {
+                print(format("%.2f\n", asFloat(value)));
+            } else {
+                print(asString(value));
+            }
+            return;
+        }
+        if (auto literal = dynamic_cast<BoolLiteral*>(&arg)) {
+            print(boolText[literal->value]);
+            return;
+        }
+        if (dynamic_cast<InterpolatedString*>(&arg)) {
+            print(asString(evaluate(&arg)));
+            return;
+        }
+
+        bool isTruthValue = false;
+        if (auto binary = dynamic_cast<BinaryExpression*>(&arg)) {
+            isTruthValue = isComparison(binary->op) || binary->op == BinaryOp::AND || binary->op == BinaryOp::OR;
+        } else if (auto unary = dynamic_cast<UnaryExpression*>(&arg)) {
+            isTruthValue = unary->op == UnaryOp::NOT;
+        }
+        if (!isTruthValue && kind(&arg) == Kind::Float) {
+            print(format("%.2f\n", number(&arg)));
+            return;
+        }
+        Value value = evaluate(&arg);
+        if (isTruthValue) {
+            print(boolText[isNonZero(value)]);
+        } else if (dynamic_cast<BinaryExpression*>(&arg) && kind(&arg) == Kind::String) {
+            print(asString(value));  // Concatenations print as text
+        } else {
+            printInt(asInt(value));
+        }
+    }
+
+    // Interpolated strings convert each part by its variable type or literal kind
+    Value interpolate(InterpolatedString& node) {
+        std::string result;
+        for (const auto& part : node.parts) {
+            result += part.isExpression ? partText(*part.expression, evaluate(part.expression.get())) : part.text;
+        }
+        return stringValue(std::move(result));
+    }
+
+    std::string partText(Expression& expr, const Value& value) {
+        auto intText = [&]() { return format("%ld", asInt(value)); };
+        auto boolText = [&]() { return std::string(isNonZero(value) ? "True" : "False"); };
+        if (auto id = dynamic_cast<Identifier*>(&expr)) {
+            const std::string& type = typeOf(*id);
+            if (type == "int") return intText();
+            if (type == "float") return format("%.2f", asFloat(value));
+            if (type == "bool") return boolText();
+            return asString(value);
+        }
+        if (dynamic_cast<IntLiteral*>(&expr)) return intText();
+        if (dynamic_cast<FloatLiteral*>(&expr)) return format("%.2f", asFloat(value));
+        if (dynamic_cast<BoolLiteral*>(&expr)) return boolText();
+        if (dynamic_cast<StringLiteral*>(&expr)) return asString(value);
+        return intText();
+    }
+};
+
+} // namespace orion
+
+#endif // PARTIAL_EVAL_H
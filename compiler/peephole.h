@@ -0,0 +1,371 @@
+#ifndef PEEPHOLE_H
+#define PEEPHOLE_H
+
+#include <array>
+#include <cctype>
+#include <map>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace orion {
+
+// Peephole optimizer over the generated assembly. The text is parsed into a list
+// of instructions, labels and opaque lines (directives, data), the rules below are
+// applied until none fires, and the list is printed back. Comment lines are
+// transparent to the rules; labels and directives end a window.
+//
+//   push-pop          push X; pop X              -> (nothing)
+//                     push X; pop Y              -> mov X, Y
+//   push-mov-pop      push R; mov S, D; pop Q    -> mov R, Q; mov S, D
+//                     (S and D do not involve Q or %rsp)
+//   self-move         mov R, R                   -> (nothing)
+//   store-load        mov R, M; mov M, R         -> mov R, M
+//                     mov R, M; mov M, Q         -> mov R, M; mov R, Q
+//   move-back         mov A, B; mov B, A         -> mov A, B
+//   float-spill       sub $8, %rsp; movsd X, (%rsp); movsd (%rsp), Y; add $8, %rsp
+//                                                -> movapd X, Y
+//   jump-to-next      jmp L / jcc L; L:          -> L:
+//   jump-over-jump    jcc L1; jmp L2; L1:        -> jncc L2; L1:
+//   unreachable       instructions after jmp/ret up to the next label are removed
+class PeepholeOptimizer {
+public:
+    enum Rule {
+        PushPop,
+        PushMovePop,
+        SelfMove,
+        StoreLoad,
+        MoveBack,
+        FloatSpill,
+        JumpToNext,
+        JumpOverJump,
+        Unreachable,
+        kRuleCount
+    };
+
+    static const char* ruleName(Rule rule) {
+        static const char* const names[kRuleCount] = {
+            "push-pop", "push-mov-pop", "self-move", "store-load", "move-back",
+            "float-spill", "jump-to-next", "jump-over-jump", "unreachable",
+        };
+        return names[rule];
+    }
+
+    std::string run(const std::string& assembly) {
+        parse(assembly);
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (size_t i = 0; i < lines.size(); i++) {
+                if (lines[i].kind == Line::Instruction && applyRules(i)) changed = true;
+            }
+            compact();
+        }
+        return print();
+    }
+
+    int count(Rule rule) const { return counts[rule]; }
+
+    void printStats(std::ostream& out) const {
+        for (int rule = 0; rule < kRuleCount; rule++) {
+            out << "peephole " << ruleName(static_cast<Rule>(rule)) << ": " << counts[rule] << "\n";
+        }
+    }
+
+private:
+    struct Line {
+        enum Kind { Instruction, Label, Comment, Opaque, Deleted };
+        Kind kind;
+        std::string text;                   // Original text, printed when unchanged
+        std::string mnemonic;
+        std::vector<std::string> operands;
+        std::string comment;
+        bool rewritten = false;
+    };
+
+    std::vector<Line> lines;
+    std::array<int, kRuleCount> counts{};
+
+    void parse(const std::string& assembly) {
+        lines.clear();
+        std::istringstream input(assembly);
+        std::string text;
+        while (std::getline(input, text)) {
+            lines.push_back(parseLine(text));
+        }
+    }
+
+    static Line parseLine(const std::string& text) {
+        Line line;
+        line.text = text;
+        size_t start = text.find_first_not_of(" \t");
+        if (start == std::string::npos || text[start] == '#') {
+            line.kind = Line::Comment;
+            return line;
+        }
+        if (start == 0) {
+            // Labels sit in column 0; data definitions (`str_0: .string ...`) are opaque
+            bool label = text.back() == ':' && text.find_first_of(" \t") == std::string::npos;
+            line.kind = label ? Line::Label : Line::Opaque;
+            if (label) line.mnemonic = text.substr(0, text.size() - 1);
+            return line;
+        }
+        if (text[start] == '.') {
+            line.kind = Line::Opaque;
+            return line;
+        }
+
+        line.kind = Line::Instruction;
+        std::string code = text.substr(start);
+        size_t hash = code.find('#');
+        if (hash != std::string::npos) {
+            line.comment = trim(code.substr(hash + 1));
+            code = code.substr(0, hash);
+        }
+        code = trim(code);
+        size_t space = code.find_first_of(" \t");
+        line.mnemonic = code.substr(0, space);
+        if (space == std::string::npos) return line;
+
+        // Operands are separated by commas outside parentheses
+        std::string rest = code.substr(space + 1);
+        int depth = 0;
+        std::string operand;
+        for (char c : rest) {
+            if (c == '(') depth++;
+            if (c == ')') depth--;
+            if (c == ',' && depth == 0) {
+                line.operands.push_back(trim(operand));
+                operand.clear();
+            } else {
+                operand += c;
+            }
+        }
+        if (!trim(operand).empty()) line.operands.push_back(trim(operand));
+        return line;
+    }
+
+    static std::string trim(const std::string& text) {
+        size_t begin = text.find_first_not_of(" \t");
+        if (begin == std::string::npos) return "";
+        size_t end = text.find_last_not_of(" \t");
+        return text.substr(begin, end - begin + 1);
+    }
+
+    std::string print() const {
+        std::ostringstream out;
+        for (const Line& line : lines) {
+            if (line.kind == Line::Deleted) continue;
+            if (!line.rewritten) {
+                out << line.text << "\n";
+                continue;
+            }
+            out << "    " << line.mnemonic;
+            for (size_t i = 0; i < line.operands.size(); i++) {
+                out << (i == 0 ? " " : ", ") << line.operands[i];
+            }
+            if (!line.comment.empty()) out << "  # " << line.comment;
+            out << "\n";
+        }
+        return out.str();
+    }
+
+    void compact() {
+        std::vector<Line> kept;
+        kept.reserve(lines.size());
+        for (Line& line : lines) {
+            if (line.kind != Line::Deleted) kept.push_back(std::move(line));
+        }
+        lines = std::move(kept);
+    }
+
+    // Next line after `index` that is not a comment, or lines.size()
+    size_t next(size_t index) const {
+        size_t i = index + 1;
+        while (i < lines.size() && (lines[i].kind == Line::Comment || lines[i].kind == Line::Deleted)) i++;
+        return i;
+    }
+
+    bool isInstruction(size_t index, const char* mnemonic, size_t operandCount) const {
+        return index < lines.size() && lines[index].kind == Line::Instruction &&
+               lines[index].mnemonic == mnemonic && lines[index].operands.size() == operandCount;
+    }
+
+    void erase(size_t index) { lines[index].kind = Line::Deleted; }
+
+    void rewrite(size_t index, const std::string& mnemonic, const std::vector<std::string>& operands) {
+        lines[index].mnemonic = mnemonic;
+        lines[index].operands = operands;
+        lines[index].rewritten = true;
+    }
+
+    static bool isRegister(const std::string& operand) {
+        return !operand.empty() && operand[0] == '%';
+    }
+
+    static bool isGeneralRegister(const std::string& operand) {
+        return isRegister(operand) && operand.compare(0, 4, "%xmm") != 0;
+    }
+
+    static bool isMemory(const std::string& operand) {
+        return operand.find('(') != std::string::npos;
+    }
+
+    // Whether an operand reads or names any part of a 64-bit general register
+    static bool mentions(const std::string& operand, const std::string& reg) {
+        static const std::map<std::string, std::vector<std::string>> aliases = {
+            {"%rax", {"%rax", "%eax", "%ax", "%al"}}, {"%rbx", {"%rbx", "%ebx", "%bx", "%bl"}},
+            {"%rcx", {"%rcx", "%ecx", "%cx", "%cl"}}, {"%rdx", {"%rdx", "%edx", "%dx", "%dl"}},
+            {"%rsi", {"%rsi", "%esi", "%si", "%sil"}}, {"%rdi", {"%rdi", "%edi", "%di", "%dil"}},
+            {"%rsp", {"%rsp", "%esp", "%sp", "%spl"}}, {"%rbp", {"%rbp", "%ebp", "%bp", "%bpl"}},
+        };
+        auto it = aliases.find(reg);
+        if (it == aliases.end()) {
+            // %r8-%r15 and their %r8d/%r8w/%r8b forms share the prefix
+            size_t pos = operand.find(reg);
+            while (pos != std::string::npos) {
+                size_t end = pos + reg.size();
+                if (end == operand.size() || !std::isdigit(static_cast<unsigned char>(operand[end]))) return true;
+                pos = operand.find(reg, end);
+            }
+            return false;
+        }
+        for (const auto& name : it->second) {
+            if (operand.find(name) != std::string::npos) return true;
+        }
+        return false;
+    }
+
+    static bool isUnconditionalExit(const Line& line) {
+        return line.kind == Line::Instruction && (line.mnemonic == "jmp" || line.mnemonic == "ret");
+    }
+
+    static std::string invertedJump(const std::string& mnemonic) {
+        static const std::map<std::string, std::string> inverse = {
+            {"je", "jne"}, {"jne", "je"}, {"jz", "jnz"}, {"jnz", "jz"},
+            {"jl", "jge"}, {"jge", "jl"}, {"jle", "jg"}, {"jg", "jle"},
+            {"jb", "jae"}, {"jae", "jb"}, {"jbe", "ja"}, {"ja", "jbe"},
+            {"js", "jns"}, {"jns", "js"}, {"jp", "jnp"}, {"jnp", "jp"},
+        };
+        auto it = inverse.find(mnemonic);
+        return it == inverse.end() ? "" : it->second;
+    }
+
+    // Whether one of the labels starting at `index` is `label`
+    bool labelFollows(size_t index, const std::string& label) const {
+        for (size_t i = index; i < lines.size() && lines[i].kind != Line::Instruction && lines[i].kind != Line::Opaque;
+             i = next(i)) {
+            if (lines[i].kind == Line::Label && lines[i].mnemonic == label) return true;
+        }
+        return false;
+    }
+
+    bool fire(Rule rule) {
+        counts[rule]++;
+        return true;
+    }
+
+    bool applyRules(size_t i) {
+        const Line& line = lines[i];
+        size_t j = next(i);
+        const std::string& op = line.mnemonic;
+
+        if ((op == "mov" || op == "movq" || op == "movapd") && line.operands.size() == 2 &&
+            isRegister(line.operands[0]) && line.operands[0] == line.operands[1]) {
+            erase(i);
+            return fire(SelfMove);
+        }
+
+        if (isUnconditionalExit(line)) {
+            bool removed = false;
+            for (size_t k = j; k < lines.size() && lines[k].kind == Line::Instruction; k = next(k)) {
+                erase(k);
+                removed = true;
+            }
+            if (removed) return fire(Unreachable);
+        }
+
+        if (op.size() > 1 && op[0] == 'j' && line.operands.size() == 1) {
+            if (labelFollows(j, line.operands[0])) {
+                erase(i);
+                return fire(JumpToNext);
+            }
+            std::string inverse = invertedJump(op);
+            if (!inverse.empty() && isInstruction(j, "jmp", 1) && labelFollows(next(j), line.operands[0])) {
+                rewrite(i, inverse, {lines[j].operands[0]});
+                erase(j);
+                return fire(JumpOverJump);
+            }
+        }
+
+        if (op == "push" && line.operands.size() == 1 && !mentions(line.operands[0], "%rsp")) {
+            const std::string& pushed = line.operands[0];
+            if (isInstruction(j, "pop", 1) && isGeneralRegister(lines[j].operands[0])) {
+                const std::string& popped = lines[j].operands[0];
+                if (pushed == popped) {
+                    erase(i);
+                } else {
+                    rewrite(i, "mov", {pushed, popped});
+                }
+                erase(j);
+                return fire(PushPop);
+            }
+            size_t k = next(j);
+            if (isGeneralRegister(pushed) && isInstruction(j, "mov", 2) && isInstruction(k, "pop", 1) &&
+                isGeneralRegister(lines[k].operands[0])) {
+                const std::string& popped = lines[k].operands[0];
+                const Line& middle = lines[j];
+                bool independent = !mentions(middle.operands[0], popped) && !mentions(middle.operands[1], popped) &&
+                                   !mentions(middle.operands[0], "%rsp") && !mentions(middle.operands[1], "%rsp");
+                if (independent) {
+                    if (pushed == popped) {
+                        erase(i);
+                    } else {
+                        rewrite(i, "mov", {pushed, popped});
+                    }
+                    erase(k);
+                    return fire(PushMovePop);
+                }
+            }
+        }
+
+        if ((op == "mov" || op == "movq" || op == "movsd") && line.operands.size() == 2 &&
+            j < lines.size() && lines[j].kind == Line::Instruction && lines[j].mnemonic == op &&
+            lines[j].operands.size() == 2) {
+            const std::string& source = line.operands[0];
+            const std::string& dest = line.operands[1];
+            const Line& after = lines[j];
+            if (isRegister(source) && after.operands[0] == dest && after.operands[1] == source &&
+                !mentions(dest, "%rsp")) {
+                erase(j);
+                return fire(isMemory(dest) ? StoreLoad : MoveBack);
+            }
+            // Forward a stored register to a load of the same slot into another register
+            if (op == "mov" && isGeneralRegister(source) && isMemory(dest) && after.operands[0] == dest &&
+                isGeneralRegister(after.operands[1]) && !mentions(dest, "%rsp")) {
+                rewrite(j, "mov", {source, after.operands[1]});
+                return fire(StoreLoad);
+            }
+        }
+
+        if (op == "sub" && line.operands.size() == 2 && line.operands[0] == "$8" && line.operands[1] == "%rsp") {
+            size_t k = next(j);
+            size_t l = next(k);
+            if (isInstruction(j, "movsd", 2) && lines[j].operands[1] == "(%rsp)" && isRegister(lines[j].operands[0]) &&
+                isInstruction(k, "movsd", 2) && lines[k].operands[0] == "(%rsp)" && isRegister(lines[k].operands[1]) &&
+                isInstruction(l, "add", 2) && lines[l].operands[0] == "$8" && lines[l].operands[1] == "%rsp") {
+                rewrite(i, "movapd", {lines[j].operands[0], lines[k].operands[1]});
+                erase(j);
+                erase(k);
+                erase(l);
+                return fire(FloatSpill);
+            }
+        }
+        return false;
+    }
+};
+
+} // namespace orion
+
+#endif // PEEPHOLE_H
@@ -0,0 +1,163 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "ast.h"
+#include "ast_walker.h"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace orion {
+
+// Execution counts of a program. With --profile-generate the code generator
+// increments a counter at each counted point and the runtime writes the counts
+// to a profile file at exit (orion_profile_start in runtime.c); with
+// --profile-use it reads them back to lay out and inline the hot paths.
+//
+// Counters are numbered by walking the AST after constant folding and dead code
+// elimination, so every build of the same source numbers them alike; the
+// checksum of the numbering rejects a profile recorded for other source.
+//   function   entries, inlined or not
+//   if         times reached, times the then branch ran
+//   loop       times reached, body iterations
+//   user call  times called (one call edge)
+class Profile {
+public:
+    enum Offset { Reached = 0, Taken = 1, Entries = 0, Iterations = 1 };
+
+    static constexpr int64_t kColdRatio = 100;       // A branch taken at most 1 in 100 times is cold
+    static constexpr int64_t kHotLoopIterations = 1000;
+    static constexpr int64_t kHotCallCount = 1000;
+
+    void number(Program& program) {
+        counters.clear();
+        size = 0;
+        checksum = 14695981039346656037ull;  // FNV-1a offset basis
+        Numberer numberer(*this);
+        program.accept(numberer);
+    }
+
+    // First counter of a node, -1 if it has none
+    int counter(ASTNode* node, int offset = 0) const {
+        auto it = counters.find(node);
+        return it == counters.end() ? -1 : it->second + offset;
+    }
+
+    int counterCount() const { return size; }
+    uint64_t numberingChecksum() const { return checksum; }
+
+    // Reads a profile written by the runtime; call after number()
+    bool read(const std::string& path, std::string& error) {
+        counts.clear();
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            error = "could not open profile " + path;
+            return false;
+        }
+        std::string magic;
+        uint64_t fileChecksum = 0;
+        int64_t fileSize = 0;
+        file >> magic >> std::hex >> fileChecksum >> std::dec >> fileSize;
+        if (!file || magic != "orion-profile") {
+            error = path + " is not a profile";
+            return false;
+        }
+        if (fileChecksum != checksum || fileSize != size) {
+            error = path + " was recorded for different source";
+            return false;
+        }
+        counts.resize(size);
+        for (auto& count : counts) {
+            if (!(file >> count)) {
+                counts.clear();
+                error = path + " is truncated";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool hasCounts() const { return !counts.empty(); }
+
+    // A node's count, -1 without a profile
+    int64_t count(ASTNode* node, int offset = 0) const {
+        int index = counter(node, offset);
+        return index < 0 || counts.empty() ? -1 : counts[index];
+    }
+
+    // Whether one branch of a reached if statement (almost) never runs
+    bool isColdBranch(IfStatement* branch, bool thenBranch) const {
+        int64_t reached = count(branch, Reached);
+        int64_t taken = count(branch, Taken);
+        if (reached <= 0 || taken < 0) return false;
+        int64_t runs = thenBranch ? taken : reached - taken;
+        return runs * kColdRatio <= reached;
+    }
+
+    bool isHotLoop(Statement* loop) const {
+        int64_t reached = count(loop, Reached);
+        int64_t iterations = count(loop, Iterations);
+        return reached > 0 && iterations >= kHotLoopIterations && iterations >= 2 * reached;
+    }
+
+    // Functions the profiled runs never entered
+    bool isColdFunction(FunctionDeclaration* func) const {
+        return count(func, Entries) == 0;
+    }
+
+private:
+    std::unordered_map<ASTNode*, int> counters;
+    int size = 0;
+    uint64_t checksum = 0;
+    std::vector<int64_t> counts;
+
+    void add(ASTNode* node, int width, const std::string& what) {
+        counters[node] = size;
+        size += width;
+        for (char c : what + ";") {
+            checksum = (checksum ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+        }
+    }
+
+    class Numberer : public RecursiveASTVisitor {
+    public:
+        explicit Numberer(Profile& profile) : profile(profile) {}
+
+        using RecursiveASTVisitor::visit;
+
+        void visit(FunctionDeclaration& node) override {
+            profile.add(&node, 1, "fn " + node.name);
+            RecursiveASTVisitor::visit(node);
+        }
+        void visit(IfStatement& node) override {
+            profile.add(&node, 2, "if");
+            RecursiveASTVisitor::visit(node);
+        }
+        void visit(WhileStatement& node) override {
+            profile.add(&node, 2, "while");
+            RecursiveASTVisitor::visit(node);
+        }
+        void visit(ForInStatement& node) override {
+            profile.add(&node, 2, "for " + node.variable);
+            RecursiveASTVisitor::visit(node);
+        }
+        void visit(FunctionCall& node) override {
+            if (!isBuiltin(node.name)) profile.add(&node, 1, "call " + node.name);
+            RecursiveASTVisitor::visit(node);
+        }
+
+    private:
+        Profile& profile;
+
+        static bool isBuiltin(const std::string& name) {
+            return name == "str" || name == "int" || name == "flt" || name == "len" || name == "append" ||
+                   name == "pop" || name == "range" || name == "out" || name == "input" || name == "dtype";
+        }
+    };
+};
+
+} // namespace orion
+
+#endif // PROFILE_H
@@ -0,0 +1,72 @@
+#ifndef STRENGTH_REDUCTION_H
+#define STRENGTH_REDUCTION_H
+
+#include <cstdint>
+
+namespace orion {
+
+// Integer arithmetic helpers shared by the constant folder and the code
+// generator, so that folded and generated code agree on every sign combination.
+//   a / b   truncates toward zero (C semantics)
+//   a // b  floors, and a % b takes the sign of b (Python semantics)
+namespace intmath {
+
+inline int64_t floorDiv(int64_t a, int64_t b) {
+    int64_t q = a / b;
+    if (a % b != 0 && ((a % b) ^ b) < 0) q--;
+    return q;
+}
+
+inline int64_t floorMod(int64_t a, int64_t b) {
+    int64_t r = a % b;
+    if (r != 0 && (r ^ b) < 0) r += b;
+    return r;
+}
+
+// k if value == 2^k (k >= 1), otherwise -1
+inline int powerOfTwoShift(int64_t value) {
+    if (value < 2 || (value & (value - 1)) != 0) return -1;
+    int k = 0;
+    while ((int64_t(1) << k) != value) k++;
+    return k;
+}
+
+// Multiplier and shift that replace signed 64-bit division by a constant
+// (Granlund & Montgomery; Hacker's Delight, 10-1). The quotient trunc(n / d) is
+//   t = high64(M * n); t += n if d > 0 && M < 0; t -= n if d < 0 && M > 0;
+//   t >>= shift (arithmetic); q = t + (t >>> 63)
+// Valid for d not in {-1, 0, 1}.
+struct DivisionMagic {
+    int64_t multiplier;
+    int shift;
+};
+
+inline DivisionMagic signedDivisionMagic(int64_t d) {
+    const uint64_t two63 = uint64_t(1) << 63;
+    uint64_t ad = d < 0 ? uint64_t(0) - uint64_t(d) : uint64_t(d);
+    uint64_t t = two63 + (uint64_t(d) >> 63);
+    uint64_t anc = t - 1 - t % ad;
+    int p = 63;
+    uint64_t q1 = two63 / anc, r1 = two63 - q1 * anc;
+    uint64_t q2 = two63 / ad, r2 = two63 - q2 * ad;
+    uint64_t delta;
+    do {
+        p++;
+        q1 *= 2;
+        r1 *= 2;
+        if (r1 >= anc) { q1++; r1 -= anc; }
+        q2 *= 2;
+        r2 *= 2;
+        if (r2 >= ad) { q2++; r2 -= ad; }
+        delta = ad - r2;
+    } while (q1 < delta || (q1 == delta && r1 == 0));
+
+    uint64_t magic = q2 + 1;
+    if (d < 0) magic = uint64_t(0) - magic;
+    return {int64_t(magic), p - 64};
+}
+
+} // namespace intmath
+} // namespace orion
+
+#endif // STRENGTH_REDUCTION_H
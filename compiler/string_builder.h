@@ -0,0 +1,157 @@
+#ifndef STRING_BUILDER_H
+#define STRING_BUILDER_H
+
+#include "ast.h"
+#include "ast_walker.h"
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace orion {
+
+// Finds the variables a loop builds up with s = s + x (or s += x) and reads
+// nowhere else but where the text is copied or only looked at: out(s), len(s),
+// comparisons and interpolation. str(s) of a string is s itself, so it counts
+// as any other read. Nothing else can hold on to such a string while the loop
+// runs, so the code generator may give it a private copy with spare room before
+// the loop and append to that in place, doubling the room as it fills, instead
+// of copying the whole prefix on every iteration.
+class StringAccumulatorScanner : public RecursiveASTVisitor {
+public:
+    explicit StringAccumulatorScanner(const std::string* loopVariable) {
+        if (loopVariable) disqualified.insert(*loopVariable);
+    }
+
+    // Candidates with the concatenations that append to them
+    std::map<std::string, std::vector<BinaryExpression*>> accumulators() const {
+        std::map<std::string, std::vector<BinaryExpression*>> found;
+        for (const auto& entry : appends) {
+            if (!disqualified.count(entry.first)) found.insert(entry);
+        }
+        return found;
+    }
+
+    using RecursiveASTVisitor::visit;
+
+    void visit(VariableDeclaration& node) override {
+        BinaryExpression* append = appendTo(node);
+        if (!append) {
+            disqualified.insert(node.name);
+            RecursiveASTVisitor::visit(node);
+            return;
+        }
+        appends[node.name].push_back(append);
+        append->right->accept(*this);
+    }
+
+    void visit(Identifier& node) override { disqualified.insert(node.name); }
+
+    void visit(FunctionCall& node) override {
+        bool looksOnly = node.name == "out" || node.name == "len";
+        for (auto& arg : node.arguments) {
+            if (!looksOnly || !dynamic_cast<Identifier*>(arg.get())) arg->accept(*this);
+        }
+    }
+
+    void visit(BinaryExpression& node) override {
+        bool comparison = node.op == BinaryOp::EQ || node.op == BinaryOp::NE || node.op == BinaryOp::LT ||
+                          node.op == BinaryOp::LE || node.op == BinaryOp::GT || node.op == BinaryOp::GE;
+        if (!comparison || !dynamic_cast<Identifier*>(node.left.get())) node.left->accept(*this);
+        if (!comparison || !dynamic_cast<Identifier*>(node.right.get())) node.right->accept(*this);
+    }
+
+    void visit(InterpolatedString& node) override {
+        for (auto& part : node.parts) {
+            if (part.isExpression && part.expression && !dynamic_cast<Identifier*>(part.expression.get())) {
+                part.expression->accept(*this);
+            }
+        }
+    }
+
+    void visit(ChainAssignment& node) override {
+        disqualified.insert(node.variables.begin(), node.variables.end());
+        RecursiveASTVisitor::visit(node);
+    }
+    void visit(TupleAssignment& node) override {
+        for (auto& target : node.targets) {
+            if (auto id = dynamic_cast<Identifier*>(target.get())) disqualified.insert(id->name);
+        }
+        RecursiveASTVisitor::visit(node);
+    }
+    void visit(ForInStatement& node) override {
+        disqualified.insert(node.variable);
+        RecursiveASTVisitor::visit(node);
+    }
+    void visit(GlobalStatement& node) override { disqualified.insert(node.variables.begin(), node.variables.end()); }
+    void visit(LocalStatement& node) override { disqualified.insert(node.variables.begin(), node.variables.end()); }
+    void visit(FunctionDeclaration&) override {}
+
+private:
+    std::unordered_map<std::string, std::vector<BinaryExpression*>> appends;
+    std::unordered_set<std::string> disqualified;
+
+    // s = s + x where x does not read s, which would see the text change under it
+    static BinaryExpression* appendTo(VariableDeclaration& node) {
+        auto binary = dynamic_cast<BinaryExpression*>(node.initializer.get());
+        if (node.isConstant || !binary || binary->op != BinaryOp::ADD) return nullptr;
+        auto left = dynamic_cast<Identifier*>(binary->left.get());
+        if (!left || left->name != node.name) return nullptr;
+        std::unordered_set<std::string> read;
+        NameReader reader(read);
+        binary->right->accept(reader);
+        return read.count(node.name) ? nullptr : binary;
+    }
+
+    class NameReader : public RecursiveASTVisitor {
+    public:
+        explicit NameReader(std::unordered_set<std::string>& names) : names(names) {}
+        using RecursiveASTVisitor::visit;
+        void visit(Identifier& node) override { names.insert(node.name); }
+    private:
+        std::unordered_set<std::string>& names;
+    };
+};
+
+// The stores a loop body makes: the declarations, whose initializer decides
+// what the variable holds, and the names it stores some other way
+class TextStoreCollector : public RecursiveASTVisitor {
+public:
+    std::vector<VariableDeclaration*> declarations;
+    std::unordered_set<std::string> otherStores;
+
+    using RecursiveASTVisitor::visit;
+
+    void visit(VariableDeclaration& node) override {
+        declarations.push_back(&node);
+        RecursiveASTVisitor::visit(node);
+    }
+    void visit(BinaryExpression& node) override {
+        if (node.op == BinaryOp::ASSIGN) {
+            if (auto id = dynamic_cast<Identifier*>(node.left.get())) otherStores.insert(id->name);
+        }
+        RecursiveASTVisitor::visit(node);
+    }
+    void visit(ChainAssignment& node) override {
+        otherStores.insert(node.variables.begin(), node.variables.end());
+        RecursiveASTVisitor::visit(node);
+    }
+    void visit(TupleAssignment& node) override {
+        for (auto& target : node.targets) {
+            if (auto id = dynamic_cast<Identifier*>(target.get())) otherStores.insert(id->name);
+        }
+        RecursiveASTVisitor::visit(node);
+    }
+    void visit(ForInStatement& node) override {
+        otherStores.insert(node.variable);
+        RecursiveASTVisitor::visit(node);
+    }
+    void visit(GlobalStatement& node) override { otherStores.insert(node.variables.begin(), node.variables.end()); }
+    void visit(LocalStatement& node) override { otherStores.insert(node.variables.begin(), node.variables.end()); }
+    void visit(FunctionDeclaration&) override {}
+};
+
+} // namespace orion
+
+#endif // STRING_BUILDER_H
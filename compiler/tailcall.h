@@ -0,0 +1,157 @@
+#ifndef TAILCALL_H
+#define TAILCALL_H
+
+#include "ast.h"
+#include "ast_walker.h"
+#include <functional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace orion {
+
+// Collects what the code generator needs to turn self recursion into a loop:
+// every call the function makes to itself, which of those sit inside a return
+// value, and whether anything else in the body has side effects.
+class RecursionScanner : public RecursiveASTVisitor {
+public:
+    using SelfCallPredicate = std::function<bool(FunctionCall&)>;
+
+    std::vector<ReturnStatement*> returns;
+    std::vector<FunctionCall*> selfCalls;
+    int selfCallsOutsideReturns = 0;
+    bool hasSideEffects = false;
+
+    explicit RecursionScanner(SelfCallPredicate isSelfCall) : isSelfCall(isSelfCall) {}
+
+    using RecursiveASTVisitor::visit;
+
+    void visit(FunctionCall& node) override {
+        RecursiveASTVisitor::visit(node);
+        if (isSelfCall(node)) {
+            selfCalls.push_back(&node);
+            if (returnDepth == 0) selfCallsOutsideReturns++;
+        } else if (!isPureBuiltin(node.name)) {
+            // Output, input, list mutation and calls to other user functions
+            hasSideEffects = true;
+        }
+    }
+
+    void visit(ReturnStatement& node) override {
+        returns.push_back(&node);
+        returnDepth++;
+        RecursiveASTVisitor::visit(node);
+        returnDepth--;
+    }
+
+    void visit(IndexAssignment& node) override {
+        hasSideEffects = true;
+        RecursiveASTVisitor::visit(node);
+    }
+
+    void visit(GlobalStatement&) override { hasSideEffects = true; }
+
+    // Nested functions are generated on their own
+    void visit(FunctionDeclaration&) override {}
+
+private:
+    SelfCallPredicate isSelfCall;
+    int returnDepth = 0;
+
+    static bool isPureBuiltin(const std::string& name) {
+        return name == "len" || name == "str" || name == "int" || name == "flt" || name == "range";
+    }
+};
+
+// Finds the untyped parameters a function only uses as integers: in +, -, *
+// and comparisons whose other side is integer arithmetic too (int literals,
+// such parameters and self calls), and as arguments of self calls. The code
+// generator adds untyped values as integers already, so these may join the
+// accumulator rewrite like int parameters. A string argument passed to such a
+// parameter is still added as a pointer, as the out-of-line code would add it;
+// any other use of the parameter (out(n), n + "x", n % 2) keeps it out.
+class IntegerParameterScanner : public RecursiveASTVisitor {
+public:
+    using SelfCallPredicate = std::function<bool(FunctionCall&)>;
+
+    IntegerParameterScanner(const std::unordered_set<std::string>& untyped, SelfCallPredicate isSelfCall)
+        : candidates(untyped), isSelfCall(isSelfCall) {}
+
+    std::unordered_set<std::string> integers() const {
+        std::unordered_set<std::string> found;
+        for (const auto& name : candidates) {
+            if (!disqualified.count(name)) found.insert(name);
+        }
+        return found;
+    }
+
+    using RecursiveASTVisitor::visit;
+
+    void visit(Identifier& node) override { disqualified.insert(node.name); }
+
+    void visit(BinaryExpression& node) override {
+        if (!isIntegerOp(node.op) || !isIntegerShaped(node.left.get()) || !isIntegerShaped(node.right.get())) {
+            RecursiveASTVisitor::visit(node);
+            return;
+        }
+        if (!isCandidate(node.left.get())) node.left->accept(*this);
+        if (!isCandidate(node.right.get())) node.right->accept(*this);
+    }
+
+    void visit(FunctionCall& node) override {
+        bool self = isSelfCall(node);
+        for (auto& arg : node.arguments) {
+            if (!self || !isCandidate(arg.get())) arg->accept(*this);
+        }
+    }
+
+    void visit(VariableDeclaration& node) override {
+        disqualified.insert(node.name);
+        RecursiveASTVisitor::visit(node);
+    }
+    void visit(ChainAssignment& node) override {
+        disqualified.insert(node.variables.begin(), node.variables.end());
+        RecursiveASTVisitor::visit(node);
+    }
+    void visit(TupleAssignment& node) override {
+        for (auto& target : node.targets) {
+            if (auto id = dynamic_cast<Identifier*>(target.get())) disqualified.insert(id->name);
+        }
+        RecursiveASTVisitor::visit(node);
+    }
+    void visit(ForInStatement& node) override {
+        disqualified.insert(node.variable);
+        RecursiveASTVisitor::visit(node);
+    }
+    void visit(GlobalStatement& node) override { disqualified.insert(node.variables.begin(), node.variables.end()); }
+    void visit(LocalStatement& node) override { disqualified.insert(node.variables.begin(), node.variables.end()); }
+    void visit(FunctionDeclaration&) override {}
+
+private:
+    const std::unordered_set<std::string>& candidates;
+    std::unordered_set<std::string> disqualified;
+    SelfCallPredicate isSelfCall;
+
+    bool isCandidate(Expression* expr) const {
+        auto id = dynamic_cast<Identifier*>(expr);
+        return id && candidates.count(id->name);
+    }
+
+    static bool isIntegerOp(BinaryOp op) {
+        return op == BinaryOp::ADD || op == BinaryOp::SUB || op == BinaryOp::MUL || op == BinaryOp::EQ ||
+               op == BinaryOp::NE || op == BinaryOp::LT || op == BinaryOp::LE || op == BinaryOp::GT ||
+               op == BinaryOp::GE;
+    }
+
+    bool isIntegerShaped(Expression* expr) const {
+        if (dynamic_cast<IntLiteral*>(expr) || isCandidate(expr)) return true;
+        if (auto call = dynamic_cast<FunctionCall*>(expr)) return isSelfCall(*call);
+        auto binary = dynamic_cast<BinaryExpression*>(expr);
+        return binary && (binary->op == BinaryOp::ADD || binary->op == BinaryOp::SUB || binary->op == BinaryOp::MUL) &&
+               isIntegerShaped(binary->left.get()) && isIntegerShaped(binary->right.get());
+    }
+};
+
+} // namespace orion
+
+#endif // TAILCALL_H
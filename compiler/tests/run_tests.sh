@@ -0,0 +1,50 @@
+#!/bin/bash
+# Regression programs: each tests/NAME.or must print tests/NAME.expected, both
+# when the compiler works the output out at compile time and when it generates
+# code for the program (--no-partial-eval), and from an instrumented build
+# (--profile-generate) and the build that uses the profile it recorded
+# (--profile-use).
+#
+# Usage, from compiler/ after make:  tests/run_tests.sh [tests/NAME.or...]
+
+cd "$(dirname "$0")/.." || exit 1
+compiler=$(pwd)
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+cp runtime.o "$work/"
+
+# Prints the output of the program in $1 compiled with the flags after it
+run() {
+    local source=$(realpath "$1")
+    shift
+    rm -f "$work/orion_asm.s" "$work/prog"
+    (cd "$work" && "$compiler/orion" "$@" "$source" </dev/null >/dev/null 2>"$work/errors")
+    if [ ! -f "$work/orion_asm.s" ]; then
+        cat "$work/errors"
+        return
+    fi
+    gcc -no-pie -o "$work/prog" "$work/orion_asm.s" "$work/runtime.o" -lm 2>/dev/null || { echo "link failed"; return; }
+    (cd "$work" && timeout 20 ./prog </dev/null 2>/dev/null)
+}
+
+passed=0
+failed=0
+for program in ${@:-tests/*.or}; do
+    expected="${program%.or}.expected"
+    rm -f "$work/profile"
+    for flags in "" "--no-partial-eval" "--profile-generate=$work/profile" "--profile-use=$work/profile"; do
+        # A program that does not compile records no profile to use
+        [[ $flags == --profile-use* && ! -f "$work/profile" ]] && continue
+        run "$program" $flags >"$work/output"
+        if diff "$work/output" "$expected" >"$work/diff"; then
+            passed=$((passed + 1))
+        else
+            failed=$((failed + 1))
+            echo "FAIL $program ${flags:-(default)}"
+            head -20 "$work/diff"
+        fi
+    done
+done
+
+echo "$passed passed, $failed failed"
+[ "$failed" -eq 0 ]
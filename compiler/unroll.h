@@ -0,0 +1,120 @@
+#ifndef UNROLL_H
+#define UNROLL_H
+
+#include "ast.h"
+#include "ast_walker.h"
+#include <cstdint>
+#include <string>
+
+namespace orion {
+
+// Decides how the code generator unrolls counted loops. Loops with a small
+// constant trip count are unrolled completely when all the copies fit the
+// budget; other counted loops with a constant step run 8, 4 or 2 copies of a
+// small body per test of the bound, and finish in the ordinary loop.
+class LoopUnrollPolicy {
+public:
+    static constexpr int64_t kFullUnrollMaxTrips = 16;
+    static constexpr int kFullUnrollBudget = 64;    // AST nodes across all copies
+    static constexpr int kUnrolledBodyBudget = 48;  // AST nodes per partially unrolled iteration
+    static constexpr int kCallWeight = 10;          // A user call may be inlined into every copy
+
+    struct Body {
+        int size = 0;
+        bool jumps = false;       // break or continue leaving this loop's body
+        bool copyable = true;     // No declarations that must be generated only once
+    };
+
+    static Body measure(Statement* body) {
+        Body info;
+        BodyScanner scanner(info);
+        body->accept(scanner);
+        return info;
+    }
+
+    static bool unrollFully(const Body& body, int64_t trips) {
+        return body.copyable && trips <= kFullUnrollMaxTrips && trips * body.size <= kFullUnrollBudget;
+    }
+
+    // Copies per test of the bound, 1 for no unrolling
+    static int unrollFactor(const Body& body) {
+        if (!body.copyable) return 1;
+        for (int factor : {8, 4, 2}) {
+            if (factor * body.size <= kUnrolledBodyBudget) return factor;
+        }
+        return 1;
+    }
+
+    // Iterations of range(start, stop, step) when all of its arguments are literals
+    static bool constantTripCount(FunctionCall& range, int64_t& start, int64_t& step, int64_t& trips) {
+        auto& args = range.arguments;
+        int64_t stop = 0;
+        start = 0;
+        step = 1;
+        if (args.size() >= 2 && !intConstant(args[0].get(), start)) return false;
+        if (!intConstant(args.size() == 1 ? args[0].get() : args[1].get(), stop)) return false;
+        if (args.size() == 3 && !intConstant(args[2].get(), step)) return false;
+        if (step == 0) return false;
+        // Unsigned, so that neither the span nor the step can overflow
+        uint64_t span = step > 0 ? uint64_t(stop) - uint64_t(start) : uint64_t(start) - uint64_t(stop);
+        uint64_t stride = step > 0 ? uint64_t(step) : uint64_t(0) - uint64_t(step);
+        bool empty = step > 0 ? stop <= start : stop >= start;
+        trips = empty ? 0 : int64_t(span / stride + (span % stride != 0));
+        return true;
+    }
+
+private:
+    static bool intConstant(Expression* expr, int64_t& value) {
+        auto literal = dynamic_cast<IntLiteral*>(expr);
+        if (literal) value = literal->value;
+        return literal != nullptr;
+    }
+
+    class BodyScanner : public RecursiveASTVisitor {
+    public:
+        explicit BodyScanner(Body& info) : info(info) {}
+
+        void visit(IntLiteral&) override { info.size++; }
+        void visit(FloatLiteral&) override { info.size++; }
+        void visit(StringLiteral&) override { info.size++; }
+        void visit(BoolLiteral&) override { info.size++; }
+        void visit(Identifier&) override { info.size++; }
+        void visit(InterpolatedString& node) override { info.size++; RecursiveASTVisitor::visit(node); }
+        void visit(BinaryExpression& node) override { info.size++; RecursiveASTVisitor::visit(node); }
+        void visit(UnaryExpression& node) override { info.size++; RecursiveASTVisitor::visit(node); }
+        void visit(FunctionCall& node) override {
+            info.size += isBuiltin(node.name) ? 1 : kCallWeight;
+            RecursiveASTVisitor::visit(node);
+        }
+        void visit(TupleExpression& node) override { info.size++; RecursiveASTVisitor::visit(node); }
+        void visit(ListLiteral& node) override { info.size++; RecursiveASTVisitor::visit(node); }
+        void visit(IndexExpression& node) override { info.size++; RecursiveASTVisitor::visit(node); }
+        void visit(VariableDeclaration& node) override { info.size++; RecursiveASTVisitor::visit(node); }
+        void visit(ExpressionStatement& node) override { info.size++; RecursiveASTVisitor::visit(node); }
+        void visit(TupleAssignment& node) override { info.size++; RecursiveASTVisitor::visit(node); }
+        void visit(ChainAssignment& node) override { info.size++; RecursiveASTVisitor::visit(node); }
+        void visit(IndexAssignment& node) override { info.size++; RecursiveASTVisitor::visit(node); }
+        void visit(ReturnStatement& node) override { info.size++; RecursiveASTVisitor::visit(node); }
+        void visit(IfStatement& node) override { info.size++; RecursiveASTVisitor::visit(node); }
+        void visit(WhileStatement& node) override { info.size++; loopDepth++; RecursiveASTVisitor::visit(node); loopDepth--; }
+        void visit(ForInStatement& node) override { info.size++; loopDepth++; RecursiveASTVisitor::visit(node); loopDepth--; }
+        void visit(BreakStatement&) override { info.size++; if (loopDepth == 0) info.jumps = true; }
+        void visit(ContinueStatement&) override { info.size++; if (loopDepth == 0) info.jumps = true; }
+        void visit(FunctionDeclaration&) override { info.copyable = false; }
+        void visit(StructDeclaration&) override { info.copyable = false; }
+        void visit(EnumDeclaration&) override { info.copyable = false; }
+
+    private:
+        Body& info;
+        int loopDepth = 0;
+
+        static bool isBuiltin(const std::string& name) {
+            return name == "str" || name == "int" || name == "flt" || name == "len" || name == "append" ||
+                   name == "pop" || name == "range" || name == "out" || name == "input" || name == "dtype";
+        }
+    };
+};
+
+} // namespace orion
+
+#endif // UNROLL_H
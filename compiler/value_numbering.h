@@ -0,0 +1,220 @@
+#ifndef VALUE_NUMBERING_H
+#define VALUE_NUMBERING_H
+
+#include "ast.h"
+#include "ast_walker.h"
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace orion {
+
+// Structural identity of a pure expression the code generator may compute once and
+// reuse: arithmetic over variables, literals and len(xs). Two expressions with the
+// same key have the same value as long as none of `names` is assigned in between
+// (and no list changes size, if the value reads a length).
+struct ValueKey {
+    std::string key;                 // Empty when the expression cannot be reused
+    std::vector<std::string> names;  // Variables the value reads
+    bool readsLength = false;
+    bool mayTrap = false;            // Divides by something other than a non-zero constant
+
+    static ValueKey of(Expression* expr) {
+        ValueKey value;
+        std::string key;
+        if (!describe(expr, key, value)) return value;
+        // Plain variables and constants are as cheap to load as a saved value
+        if (dynamic_cast<BinaryExpression*>(expr) || dynamic_cast<UnaryExpression*>(expr) ||
+            dynamic_cast<FunctionCall*>(expr)) {
+            value.key = key;
+        }
+        return value;
+    }
+
+private:
+    static bool describe(Expression* expr, std::string& key, ValueKey& value) {
+        if (auto literal = dynamic_cast<IntLiteral*>(expr)) {
+            key += std::to_string(literal->value);
+            return true;
+        }
+        if (auto literal = dynamic_cast<FloatLiteral*>(expr)) {
+            char text[32];
+            std::snprintf(text, sizeof text, "%a", literal->value);  // Exact, unlike %g
+            key += text;
+            return true;
+        }
+        if (auto id = dynamic_cast<Identifier*>(expr)) {
+            key += id->name;
+            value.names.push_back(id->name);
+            return true;
+        }
+        if (auto unary = dynamic_cast<UnaryExpression*>(expr)) {
+            if (unary->op != UnaryOp::MINUS) return false;
+            key += "(-";
+            if (!describe(unary->operand.get(), key, value)) return false;
+            key += ")";
+            return true;
+        }
+        if (auto binary = dynamic_cast<BinaryExpression*>(expr)) {
+            const char* op = arithmeticOperator(binary->op);
+            if (!op) return false;
+            if (binary->op == BinaryOp::DIV || binary->op == BinaryOp::FLOOR_DIV || binary->op == BinaryOp::MOD) {
+                auto divisor = dynamic_cast<IntLiteral*>(binary->right.get());
+                if (!divisor || divisor->value == 0) value.mayTrap = true;
+            }
+            key += "(";
+            if (!describe(binary->left.get(), key, value)) return false;
+            key += op;
+            if (!describe(binary->right.get(), key, value)) return false;
+            key += ")";
+            return true;
+        }
+        if (auto call = dynamic_cast<FunctionCall*>(expr)) {
+            if (call->name != "len" || call->arguments.size() != 1) return false;
+            auto list = dynamic_cast<Identifier*>(call->arguments[0].get());
+            if (!list) return false;
+            key += "len(" + list->name + ")";
+            value.names.push_back(list->name);
+            value.readsLength = true;
+            return true;
+        }
+        return false;
+    }
+
+    static const char* arithmeticOperator(BinaryOp op) {
+        switch (op) {
+            case BinaryOp::ADD: return "+";
+            case BinaryOp::SUB: return "-";
+            case BinaryOp::MUL: return "*";
+            case BinaryOp::DIV: return "/";
+            case BinaryOp::FLOOR_DIV: return "//";
+            case BinaryOp::MOD: return "%";
+            case BinaryOp::POWER: return "**";
+            default: return nullptr;
+        }
+    }
+};
+
+// What running a piece of code may do to values the code generator keeps around
+class CallEffectScanner : public RecursiveASTVisitor {
+public:
+    bool callsUserFunction = false;  // May assign globals, through `global` in the callee
+    bool resizesLists = false;
+
+    using RecursiveASTVisitor::visit;
+
+    void visit(FunctionCall& node) override {
+        if (node.name == "append" || node.name == "pop") {
+            resizesLists = true;
+        } else if (!isReadOnlyBuiltin(node.name)) {
+            callsUserFunction = true;
+            resizesLists = true;
+        }
+        RecursiveASTVisitor::visit(node);
+    }
+
+    void visit(GlobalStatement&) override { callsUserFunction = true; }
+    void visit(LocalStatement&) override { callsUserFunction = true; }
+    void visit(FunctionDeclaration&) override {}
+
+private:
+    static bool isReadOnlyBuiltin(const std::string& name) {
+        return name == "str" || name == "int" || name == "flt" || name == "len" ||
+               name == "range" || name == "out" || name == "input" || name == "dtype";
+    }
+};
+
+// Keys of expressions that occur more than once in a function body (or the
+// top-level code), so that the first evaluation is worth saving. Occurrences inside
+// a repeated expression do not count: reusing the outer value skips them.
+class RepeatedValueCounter : public RecursiveASTVisitor {
+public:
+    std::unordered_set<std::string> run(const std::vector<Statement*>& statements) {
+        counts.clear();
+        outerCounts.clear();
+        counting = true;
+        for (Statement* stmt : statements) stmt->accept(*this);
+        outerCounts.swap(counts);
+        counting = false;
+        for (Statement* stmt : statements) stmt->accept(*this);
+
+        std::unordered_set<std::string> repeated;
+        for (const auto& entry : counts) {
+            if (entry.second > 1) repeated.insert(entry.first);
+        }
+        return repeated;
+    }
+
+    using RecursiveASTVisitor::visit;
+
+    void visit(BinaryExpression& node) override {
+        if (!record(&node)) RecursiveASTVisitor::visit(node);
+    }
+    void visit(UnaryExpression& node) override {
+        if (!record(&node)) RecursiveASTVisitor::visit(node);
+    }
+    void visit(FunctionCall& node) override {
+        if (!record(&node)) RecursiveASTVisitor::visit(node);
+    }
+    void visit(FunctionDeclaration&) override {}
+
+private:
+    std::unordered_map<std::string, int> counts;
+    std::unordered_map<std::string, int> outerCounts;  // All occurrences, from the first walk
+    bool counting = true;
+
+    // Counts the expression; true when its operands need not be visited
+    bool record(Expression* expr) {
+        ValueKey value = ValueKey::of(expr);
+        if (value.key.empty()) return false;
+        counts[value.key]++;
+        if (counting) return false;
+        auto it = outerCounts.find(value.key);
+        return it != outerCounts.end() && it->second > 1;
+    }
+};
+
+// Maximal pure subexpressions of a loop that keep their value on every iteration
+// and cannot trap, so they may be computed once before the loop, even when it runs
+// zero times
+class LoopInvariantScanner : public RecursiveASTVisitor {
+public:
+    std::vector<Expression*> invariants;
+
+    LoopInvariantScanner(const std::unordered_set<std::string>& assigned, bool resizesLists)
+        : assigned(assigned), resizesLists(resizesLists) {}
+
+    using RecursiveASTVisitor::visit;
+
+    void visit(BinaryExpression& node) override {
+        if (!record(&node)) RecursiveASTVisitor::visit(node);
+    }
+    void visit(UnaryExpression& node) override {
+        if (!record(&node)) RecursiveASTVisitor::visit(node);
+    }
+    void visit(FunctionCall& node) override {
+        if (!record(&node)) RecursiveASTVisitor::visit(node);
+    }
+    void visit(FunctionDeclaration&) override {}
+
+private:
+    const std::unordered_set<std::string>& assigned;
+    bool resizesLists;
+    std::unordered_set<std::string> seen;
+
+    bool record(Expression* expr) {
+        ValueKey value = ValueKey::of(expr);
+        if (value.key.empty() || value.mayTrap || (value.readsLength && resizesLists)) return false;
+        for (const auto& name : value.names) {
+            if (assigned.count(name)) return false;
+        }
+        if (seen.insert(value.key).second) invariants.push_back(expr);
+        return true;
+    }
+};
+
+} // namespace orion
+
+#endif // VALUE_NUMBERING_H
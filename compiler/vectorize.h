@@ -0,0 +1,154 @@
+#ifndef VECTORIZE_H
+#define VECTORIZE_H
+
+#include "ast.h"
+#include <string>
+#include <vector>
+
+namespace orion {
+
+// A counted loop over list data that a single runtime vector kernel can run:
+//   Sum       for v in xs { acc = acc + v }            acc += orion_vec_sum
+//   CountIf   for v in xs { if v < c { n = n + 1 } }   n += orion_vec_count_cmp
+//   Add       for i in range(k) { zs[i] = xs[i] + ys[i] }   orion_vec_add
+//   Subtract  for i in range(k) { zs[i] = xs[i] - ys[i] }   orion_vec_sub
+// Sum and CountIf also match the index form, reading xs[i] in a range loop.
+struct VectorLoop {
+    enum class Kind { Sum, CountIf, Add, Subtract };
+
+    // Comparison codes understood by orion_vec_count_cmp (ORION_CMP_* in runtime.c)
+    enum Compare { EQ = 0, NE, LT, LE, GT, GE };
+
+    Kind kind = Kind::Sum;
+    bool overList = false;             // for v in xs, rather than for i in range(stop)
+    Expression* stop = nullptr;        // Range form: the bound
+    std::string target;                // Accumulator (Sum, CountIf) or destination list
+    std::vector<std::string> sources;  // Range form: lists read at the loop index
+    Compare compare = EQ;              // CountIf: element <compare> bound
+    Expression* bound = nullptr;       // CountIf: an int literal or variable
+
+    // Whether `loop` has one of the shapes above. Variable types are left to the
+    // code generator.
+    static bool match(ForInStatement& loop, VectorLoop& vector) {
+        vector = VectorLoop();
+        if (auto range = dynamic_cast<FunctionCall*>(loop.iterable.get())) {
+            if (range->name == "range") {
+                if (range->arguments.size() == 2) {
+                    auto start = dynamic_cast<IntLiteral*>(range->arguments[0].get());
+                    if (!start || start->value != 0) return false;
+                } else if (range->arguments.size() != 1) {
+                    return false;
+                }
+                vector.stop = range->arguments.back().get();
+            }
+        }
+        vector.overList = vector.stop == nullptr;
+
+        Statement* stmt = onlyStatement(loop.body.get());
+        if (auto assign = dynamic_cast<VariableDeclaration*>(stmt)) {
+            Expression* element = increment(assign);
+            if (!element || !vector.readsElement(element, loop.variable)) return false;
+            vector.kind = Kind::Sum;
+            vector.target = assign->name;
+        } else if (auto branch = dynamic_cast<IfStatement*>(stmt)) {
+            if (branch->elseBranch) return false;
+            auto assign = dynamic_cast<VariableDeclaration*>(onlyStatement(branch->thenBranch.get()));
+            auto one = assign ? dynamic_cast<IntLiteral*>(increment(assign)) : nullptr;
+            if (!one || one->value != 1) return false;
+            if (!vector.matchCompare(branch->condition.get(), loop.variable)) return false;
+            vector.kind = Kind::CountIf;
+            vector.target = assign->name;
+        } else if (auto store = dynamic_cast<IndexAssignment*>(stmt)) {
+            auto list = dynamic_cast<Identifier*>(store->object.get());
+            auto value = dynamic_cast<BinaryExpression*>(store->value.get());
+            if (vector.overList || !list || !isVariable(store->index.get(), loop.variable) || !value ||
+                (value->op != BinaryOp::ADD && value->op != BinaryOp::SUB) ||
+                !vector.readsElement(value->left.get(), loop.variable) ||
+                !vector.readsElement(value->right.get(), loop.variable)) {
+                return false;
+            }
+            vector.kind = value->op == BinaryOp::ADD ? Kind::Add : Kind::Subtract;
+            vector.target = list->name;
+        } else {
+            return false;
+        }
+
+        // The loop variable only indexes, and an accumulator is not one of the lists.
+        // A destination list may be one of the sources: each index is read before it is written.
+        if (vector.target == loop.variable) return false;
+        bool accumulates = vector.kind == Kind::Sum || vector.kind == Kind::CountIf;
+        for (const auto& list : vector.sources) {
+            if (list == loop.variable || (accumulates && list == vector.target)) return false;
+        }
+        if (auto id = dynamic_cast<Identifier*>(vector.bound)) {
+            if (id->name == loop.variable || id->name == vector.target) return false;
+        }
+        return true;
+    }
+
+private:
+    static Statement* onlyStatement(Statement* stmt) {
+        while (auto block = dynamic_cast<BlockStatement*>(stmt)) {
+            if (block->statements.size() != 1) return nullptr;
+            stmt = block->statements[0].get();
+        }
+        return stmt;
+    }
+
+    static bool isVariable(Expression* expr, const std::string& name) {
+        auto id = dynamic_cast<Identifier*>(expr);
+        return id && id->name == name;
+    }
+
+    // e for `x = x + e` or `x = e + x`
+    static Expression* increment(VariableDeclaration* assign) {
+        auto sum = dynamic_cast<BinaryExpression*>(assign->initializer.get());
+        if (assign->isConstant || !sum || sum->op != BinaryOp::ADD) return nullptr;
+        Expression* other = nullptr;
+        if (isVariable(sum->left.get(), assign->name)) {
+            other = sum->right.get();
+        } else if (isVariable(sum->right.get(), assign->name)) {
+            other = sum->left.get();
+        }
+        return other;
+    }
+
+    // The current element: the loop variable itself, or xs[i] in a range loop
+    bool readsElement(Expression* expr, const std::string& variable) {
+        if (overList) return isVariable(expr, variable);
+        auto access = dynamic_cast<IndexExpression*>(expr);
+        if (!access || !isVariable(access->index.get(), variable)) return false;
+        auto list = dynamic_cast<Identifier*>(access->object.get());
+        if (!list) return false;
+        sources.push_back(list->name);
+        return true;
+    }
+
+    bool matchCompare(Expression* condition, const std::string& variable) {
+        auto test = dynamic_cast<BinaryExpression*>(condition);
+        if (!test) return false;
+        bool elementLeft = true;
+        Expression* other = test->right.get();
+        if (!readsElement(test->left.get(), variable)) {
+            if (!readsElement(test->right.get(), variable)) return false;
+            elementLeft = false;
+            other = test->left.get();
+        }
+        if (!dynamic_cast<IntLiteral*>(other) && !dynamic_cast<Identifier*>(other)) return false;
+        bound = other;
+
+        switch (test->op) {
+            case BinaryOp::EQ: compare = EQ; return true;
+            case BinaryOp::NE: compare = NE; return true;
+            case BinaryOp::LT: compare = elementLeft ? LT : GT; return true;
+            case BinaryOp::LE: compare = elementLeft ? LE : GE; return true;
+            case BinaryOp::GT: compare = elementLeft ? GT : LT; return true;
+            case BinaryOp::GE: compare = elementLeft ? GE : LE; return true;
+            default: return false;
+        }
+    }
+};
+
+} // namespace orion
+
+#endif // VECTORIZE_H